@@ -18,6 +18,7 @@
 #include "core/image.h"
 #include "core/time.h"
 #include "figure/formation.h"
+#include "game/replay.h"
 #include "game/undo.h"
 #include "graphics/window.h"
 #include "map/aqueduct.h"
@@ -545,6 +546,7 @@ void building_construction_place(void)
     if (!type) {
         return;
     }
+    game_replay_record_construction(data.type, data.sub_type, data.road_orientation, x_start, y_start, x_end, y_end);
     if (city_finance_out_of_money()) {
         map_property_clear_constructing_and_deleted();
         city_warning_show(WARNING_OUT_OF_MONEY);
@@ -670,6 +672,18 @@ void building_construction_place(void)
     }
 }
 
+void building_construction_place_from_replay(building_type type, building_type sub_type, int road_orientation,
+    int x_start, int y_start, int x_end, int y_end)
+{
+    building_construction_set_type(type);
+    data.sub_type = sub_type;
+    data.road_orientation = road_orientation;
+    building_construction_start(x_start, y_start, map_grid_offset(x_start, y_start));
+    building_construction_update(x_end, y_end, map_grid_offset(x_end, y_end));
+    building_construction_place();
+    building_construction_clear_type();
+}
+
 static void set_warning(int *warning_id, int warning)
 {
     if (warning_id) {
@@ -25,6 +25,9 @@ void building_construction_update(int x, int y, int grid_offset);
 
 void building_construction_place(void);
 
+void building_construction_place_from_replay(building_type type, building_type sub_type, int road_orientation,
+    int x_start, int y_start, int x_end, int y_end);
+
 int building_construction_can_place_on_terrain(int x, int y, int *warning_id);
 
 void building_construction_update_road_orientation(void);
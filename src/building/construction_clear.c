@@ -4,6 +4,7 @@
 #include "city/warning.h"
 #include "core/config.h"
 #include "figuretype/migrant.h"
+#include "game/replay.h"
 #include "game/undo.h"
 #include "graphics/window.h"
 #include "map/aqueduct.h"
@@ -24,6 +25,7 @@ static struct {
     int y_end;
     int bridge_confirmed;
     int fort_confirmed;
+    void (*pending)(int accepted);
 } confirm;
 
 static building *get_deletable_building(int grid_offset)
@@ -169,6 +171,8 @@ static int clear_land_confirmed(int measure_only, int x_start, int y_start, int
 
 static void confirm_delete_fort(int accepted)
 {
+    confirm.pending = 0;
+    game_replay_record_clear_land_confirmation(accepted);
     if (accepted == 1) {
         confirm.fort_confirmed = 1;
     } else {
@@ -179,6 +183,8 @@ static void confirm_delete_fort(int accepted)
 
 static void confirm_delete_bridge(int accepted)
 {
+    confirm.pending = 0;
+    game_replay_record_clear_land_confirmation(accepted);
     if (accepted == 1) {
         confirm.bridge_confirmed = 1;
     } else {
@@ -220,12 +226,25 @@ int building_construction_clear_land(int measure_only, int x_start, int y_start,
     confirm.x_end = x_end;
     confirm.y_end = y_end;
     if (ask_confirm_fort) {
-        window_popup_dialog_show(POPUP_DIALOG_DELETE_FORT, confirm_delete_fort, 2);
+        confirm.pending = confirm_delete_fort;
+        if (!game_replay_is_playing()) {
+            window_popup_dialog_show(POPUP_DIALOG_DELETE_FORT, confirm_delete_fort, 2);
+        }
         return -1;
     } else if (ask_confirm_bridge) {
-        window_popup_dialog_show(POPUP_DIALOG_DELETE_BRIDGE, confirm_delete_bridge, 2);
+        confirm.pending = confirm_delete_bridge;
+        if (!game_replay_is_playing()) {
+            window_popup_dialog_show(POPUP_DIALOG_DELETE_BRIDGE, confirm_delete_bridge, 2);
+        }
         return -1;
     } else {
         return clear_land_confirmed(measure_only, x_start, y_start, x_end, y_end);
     }
 }
+
+void building_construction_clear_land_confirm(int accepted)
+{
+    if (confirm.pending) {
+        confirm.pending(accepted);
+    }
+}
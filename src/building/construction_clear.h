@@ -12,4 +12,10 @@
  */
 int building_construction_clear_land(int measure_only, int x_start, int y_start, int x_end, int y_end);
 
+/**
+ * Answers the question whether a fort or bridge should be removed, without showing the dialog
+ * @param accepted 1 if the removal is accepted, -1 if it is not
+ */
+void building_construction_clear_land_confirm(int accepted);
+
 #endif // BUILDING_CONSTRUCTION_CLEAR_H
@@ -1052,3 +1052,17 @@ void city_data_load_state(buffer *main, buffer *faction, buffer *faction_unknown
 
     load_entry_exit(entry_exit_xy, entry_exit_grid_offset);
 }
+
+// offsets in the main city data, following the layout of save_main_data:
+// the treasury comes after the other player data, eight unknown bytes and the tax percentage
+#define MAIN_DATA_TREASURY_OFFSET (18068 + 8 + 4)
+// the population comes after the treasury, the sentiment, three health values and an unknown value
+#define MAIN_DATA_POPULATION_OFFSET (MAIN_DATA_TREASURY_OFFSET + 6 * 4)
+
+void city_data_load_basic_info(buffer *main, int *population, int *treasury)
+{
+    buffer_set(main, MAIN_DATA_TREASURY_OFFSET);
+    *treasury = buffer_read_i32(main);
+    buffer_set(main, MAIN_DATA_POPULATION_OFFSET);
+    *population = buffer_read_i32(main);
+}
@@ -15,4 +15,12 @@ void city_data_save_state(buffer *main, buffer *faction, buffer *faction_unknown
 void city_data_load_state(buffer *main, buffer *faction, buffer *faction_unknown, buffer *graph_order,
                           buffer *entry_exit_xy, buffer *entry_exit_grid_offset);
 
+/**
+ * Reads only the population and treasury from saved city data
+ * @param main Saved city data
+ * @param population Population
+ * @param treasury Treasury
+ */
+void city_data_load_basic_info(buffer *main, int *population, int *treasury);
+
 #endif // CITY_DATA_H
@@ -40,6 +40,14 @@ static int CATEGORY_FOR_BUILDING_TYPE[] = {
     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 //120
 };
 
+// buildings in use that employ workers, by increasing id
+static struct {
+    int water[MAX_BUILDINGS];
+    int num_water;
+    int others[MAX_BUILDINGS];
+    int num_others;
+} labor_buildings;
+
 static struct {
     labor_category category;
     int workers;
@@ -166,6 +174,27 @@ static int should_have_workers(building *b, int category, int check_access)
     return 1;
 }
 
+static void add_labor_building(int building_id, int category)
+{
+    if (category == LABOR_CATEGORY_WATER) {
+        labor_buildings.water[labor_buildings.num_water++] = building_id;
+    } else if (category >= 0) {
+        labor_buildings.others[labor_buildings.num_others++] = building_id;
+    }
+}
+
+static void find_labor_buildings(void)
+{
+    labor_buildings.num_water = 0;
+    labor_buildings.num_others = 0;
+    for (int i = 1; i < MAX_BUILDINGS; i++) {
+        building *b = building_get(i);
+        if (b->state == BUILDING_STATE_IN_USE) {
+            add_labor_building(i, CATEGORY_FOR_BUILDING_TYPE[b->type]);
+        }
+    }
+}
+
 static void calculate_workers_needed_per_category(void)
 {
     for (int cat = 0; cat < MAX_CATS; cat++) {
@@ -174,6 +203,8 @@ static void calculate_workers_needed_per_category(void)
         city_data.labor.categories[cat].workers_allocated = 0;
         city_data.labor.categories[cat].workers_needed = 0;
     }
+    labor_buildings.num_water = 0;
+    labor_buildings.num_others = 0;
     for (int i = 1; i < MAX_BUILDINGS; i++) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE) {
@@ -181,6 +212,7 @@ static void calculate_workers_needed_per_category(void)
         }
         int category = CATEGORY_FOR_BUILDING_TYPE[b->type];
         b->labor_category = category;
+        add_labor_building(i, category);
         if (!should_have_workers(b, category, 1)) {
             continue;
         }
@@ -287,21 +319,17 @@ static void check_employment(void)
 static void set_building_worker_weight(void)
 {
     int water_per_10k_per_building = calc_percentage(100, city_data.labor.categories[LABOR_CATEGORY_WATER].buildings);
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE) {
-            continue;
-        }
+    for (int i = 0; i < labor_buildings.num_water; i++) {
+        building_get(labor_buildings.water[i])->percentage_houses_covered = water_per_10k_per_building;
+    }
+    for (int i = 0; i < labor_buildings.num_others; i++) {
+        building *b = building_get(labor_buildings.others[i]);
         int cat = CATEGORY_FOR_BUILDING_TYPE[b->type];
-        if (cat == LABOR_CATEGORY_WATER) {
-            b->percentage_houses_covered = water_per_10k_per_building;
-        } else if (cat >= 0) {
-            b->percentage_houses_covered = 0;
-            if (b->houses_covered) {
-                b->percentage_houses_covered =
-                    calc_percentage(100 * b->houses_covered,
-                        city_data.labor.categories[cat].total_houses_covered);
-            }
+        b->percentage_houses_covered = 0;
+        if (b->houses_covered) {
+            b->percentage_houses_covered =
+                calc_percentage(100 * b->houses_covered,
+                    city_data.labor.categories[cat].total_houses_covered);
         }
     }
 }
@@ -321,16 +349,15 @@ static void allocate_workers_to_water(void)
     } else {
         workers_per_building = water_cat->workers_allocated / (water_cat->buildings - buildings_to_skip);
     }
-    int building_id = start_building_id;
+    // go round the water buildings, starting from where the previous allocation ran out of workers
+    int first = 0;
+    while (first < labor_buildings.num_water && labor_buildings.water[first] < start_building_id) {
+        first++;
+    }
     start_building_id = 0;
-    for (int guard = 1; guard < MAX_BUILDINGS; guard++, building_id++) {
-        if (building_id >= 2000) {
-            building_id = 1;
-        }
+    for (int i = 0; i < labor_buildings.num_water; i++) {
+        int building_id = labor_buildings.water[(first + i) % labor_buildings.num_water];
         building *b = building_get(building_id);
-        if (b->state != BUILDING_STATE_IN_USE || CATEGORY_FOR_BUILDING_TYPE[b->type] != LABOR_CATEGORY_WATER) {
-            continue;
-        }
         b->num_workers = 0;
         if (b->percentage_houses_covered > 0) {
             if (percentage_not_filled > 0) {
@@ -363,16 +390,10 @@ static void allocate_workers_to_non_water_buildings(void)
             city_data.labor.categories[i].workers_allocated < city_data.labor.categories[i].workers_needed
             ? 1 : 0;
     }
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE) {
-            continue;
-        }
+    // water is handled by allocate_workers_to_water(void)
+    for (int i = 0; i < labor_buildings.num_others; i++) {
+        building *b = building_get(labor_buildings.others[i]);
         int cat = CATEGORY_FOR_BUILDING_TYPE[b->type];
-        if (cat == LABOR_CATEGORY_WATER || cat < 0) {
-            // water is handled by allocate_workers_to_water(void)
-            continue;
-        }
         b->num_workers = 0;
         if (!should_have_workers(b, cat, 0)) {
             continue;
@@ -404,13 +425,10 @@ static void allocate_workers_to_non_water_buildings(void)
             }
         }
     }
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE) {
-            continue;
-        }
+    for (int i = 0; i < labor_buildings.num_others; i++) {
+        building *b = building_get(labor_buildings.others[i]);
         int cat = CATEGORY_FOR_BUILDING_TYPE[b->type];
-        if (cat < 0 || cat == LABOR_CATEGORY_WATER || cat == LABOR_CATEGORY_MILITARY) {
+        if (cat == LABOR_CATEGORY_MILITARY) {
             continue;
         }
         if (!should_have_workers(b, cat, 0)) {
@@ -441,6 +459,7 @@ static void allocate_workers_to_buildings(void)
 
 void city_labor_allocate_workers(void)
 {
+    find_labor_buildings();
     allocate_workers_to_categories();
     allocate_workers_to_buildings();
 }
@@ -30,6 +30,22 @@ static int check_size(buffer *buf, int size)
     return 1;
 }
 
+static int is_little_endian(void)
+{
+    const uint16_t value = 1;
+    return *(const uint8_t *) &value;
+}
+
+static int fitting_values(buffer *buf, int value_size, int count)
+{
+    int available = (buf->size - buf->index) / value_size;
+    if (count > available) {
+        buf->overflow = 1;
+        return available;
+    }
+    return count;
+}
+
 void buffer_write_u8(buffer *buf, uint8_t value)
 {
     if (check_size(buf, 1)) {
@@ -88,6 +104,19 @@ void buffer_write_raw(buffer *buf, const void *value, int size)
     }
 }
 
+void buffer_write_u16_array(buffer *buf, const uint16_t *values, int count)
+{
+    int fitting = fitting_values(buf, 2, count);
+    if (is_little_endian()) {
+        memcpy(&buf->data[buf->index], values, fitting * 2);
+        buf->index += fitting * 2;
+    } else {
+        for (int i = 0; i < fitting; i++) {
+            buffer_write_u16(buf, values[i]);
+        }
+    }
+}
+
 uint8_t buffer_read_u8(buffer *buf)
 {
     if (check_size(buf, 1)) {
@@ -154,6 +183,21 @@ int32_t buffer_read_i32(buffer *buf)
     }
 }
 
+void buffer_read_u16_array(buffer *buf, uint16_t *values, int count)
+{
+    int fitting = fitting_values(buf, 2, count);
+    if (is_little_endian()) {
+        memcpy(values, &buf->data[buf->index], fitting * 2);
+        buf->index += fitting * 2;
+    } else {
+        for (int i = 0; i < fitting; i++) {
+            values[i] = buffer_read_u16(buf);
+        }
+    }
+    // values beyond the end of the buffer read as zero, as with buffer_read_u16
+    memset(&values[fitting], 0, (count - fitting) * sizeof(uint16_t));
+}
+
 int buffer_read_raw(buffer *buf, void *value, int max_size)
 {
     int size = buf->size - buf->index;
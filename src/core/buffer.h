@@ -81,6 +81,14 @@ void buffer_write_i16(buffer *buffer, int16_t value);
  */
 void buffer_write_i32(buffer *buffer, int32_t value);
 
+/**
+ * Writes an array of unsigned 16-bit integers in little-endian order
+ * @param buffer Buffer
+ * @param values Values to write
+ * @param count Number of values to write
+ */
+void buffer_write_u16_array(buffer *buffer, const uint16_t *values, int count);
+
 /**
  * Writes raw data
  * @param buffer Buffer
@@ -132,6 +140,14 @@ int16_t buffer_read_i16(buffer *buffer);
  */
 int32_t buffer_read_i32(buffer *buffer);
 
+/**
+ * Reads an array of unsigned 16-bit integers, stored in little-endian order
+ * @param buffer Buffer
+ * @param values Array to read into
+ * @param count Number of values to read
+ */
+void buffer_read_u16_array(buffer *buffer, uint16_t *values, int count);
+
 /**
  * Reads raw data
  * @param buffer Buffer
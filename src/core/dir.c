@@ -5,17 +5,50 @@
 #include "core/string.h"
 #include "platform/file_manager.h"
 
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #define BASE_MAX_FILES 100
+#define MAX_CASE_INDEXES 8
+#define MAX_LISTING_EXTENSION 16
+
+typedef struct {
+    char *dir;
+    int type;
+    int64_t modified_time;
+    int needs_refresh;
+    int last_used;
+    char **names;
+    int num_names;
+    int max_names;
+    int *hash_table;
+    int hash_size;
+} case_index;
 
 static struct {
     dir_listing listing;
     int max_files;
+    struct {
+        int valid;
+        int type;
+        char extension[MAX_LISTING_EXTENSION];
+        int64_t modified_time;
+    } cached_listing;
+    case_index case_indexes[MAX_CASE_INDEXES];
+    case_index *building_index;
+    int case_index_uses;
     char *cased_filename;
 } data;
 
+static int is_recently_modified(int64_t modified_time)
+{
+    // Modification times have a resolution of one second, so a change made in the same
+    // second as the directory was read would go unnoticed: read it again next time
+    return (int64_t) time(0) - modified_time <= 1;
+}
+
 static void allocate_listing_files(int min, int max)
 {
     for (int i = min; i < max; i++) {
@@ -64,20 +97,39 @@ static int add_to_listing(const char *filename)
     return LIST_CONTINUE;
 }
 
-const dir_listing *dir_find_files_with_extension(const char *extension)
+static const dir_listing *find_files(int type, const char *extension)
 {
+    if (!extension) {
+        extension = "";
+    }
+    int64_t modified_time = platform_file_manager_get_modified_time(".");
+    if (data.cached_listing.valid && data.cached_listing.type == type &&
+        data.cached_listing.modified_time == modified_time &&
+        strcmp(data.cached_listing.extension, extension) == 0) {
+        return &data.listing;
+    }
     clear_dir_listing();
-    platform_file_manager_list_directory_contents(0, TYPE_FILE, extension, add_to_listing);
+    platform_file_manager_list_directory_contents(0, type, extension, add_to_listing);
     qsort(data.listing.files, data.listing.num_files, sizeof(char*), compare_lower);
+
+    data.cached_listing.valid = modified_time && !is_recently_modified(modified_time) &&
+        strlen(extension) < MAX_LISTING_EXTENSION;
+    if (data.cached_listing.valid) {
+        data.cached_listing.type = type;
+        data.cached_listing.modified_time = modified_time;
+        strcpy(data.cached_listing.extension, extension);
+    }
     return &data.listing;
 }
 
+const dir_listing *dir_find_files_with_extension(const char *extension)
+{
+    return find_files(TYPE_FILE, extension);
+}
+
 const dir_listing *dir_find_all_subdirectories(void)
 {
-    clear_dir_listing();
-    platform_file_manager_list_directory_contents(0, TYPE_DIR, 0, add_to_listing);
-    qsort(data.listing.files, data.listing.num_files, sizeof(char*), compare_lower);
-    return &data.listing;
+    return find_files(TYPE_DIR, 0);
 }
 
 static int compare_case(const char *filename)
@@ -89,10 +141,146 @@ static int compare_case(const char *filename)
     return LIST_NO_MATCH;
 }
 
+static unsigned int hash_case_insensitive(const char *name)
+{
+    // Uses the same lowercase conversion as string_compare_case_insensitive
+    unsigned int hash = 2166136261u;
+    while (*name) {
+        hash = (hash ^ (uint8_t) tolower(*name)) * 16777619u;
+        name++;
+    }
+    return hash;
+}
+
+static void clear_case_index(case_index *index)
+{
+    for (int i = 0; i < index->num_names; i++) {
+        free(index->names[i]);
+    }
+    free(index->names);
+    free(index->hash_table);
+    index->names = 0;
+    index->num_names = 0;
+    index->max_names = 0;
+    index->hash_table = 0;
+    index->hash_size = 0;
+}
+
+static int add_to_case_index(const char *filename)
+{
+    case_index *index = data.building_index;
+    if (index->num_names >= index->max_names) {
+        int max_names = index->max_names ? 2 * index->max_names : BASE_MAX_FILES;
+        char **names = (char **) realloc(index->names, max_names * sizeof(char *));
+        if (!names) {
+            return LIST_MATCH;
+        }
+        index->names = names;
+        index->max_names = max_names;
+    }
+    char *name = (char *) malloc(strlen(filename) + 1);
+    if (!name) {
+        return LIST_MATCH;
+    }
+    strcpy(name, filename);
+    index->names[index->num_names++] = name;
+    return LIST_CONTINUE;
+}
+
+static const char *find_in_case_index(const case_index *index, const char *filename)
+{
+    unsigned int slot = hash_case_insensitive(filename) & (index->hash_size - 1);
+    while (index->hash_table[slot]) {
+        const char *name = index->names[index->hash_table[slot] - 1];
+        if (string_compare_case_insensitive(name, filename) == 0) {
+            return name;
+        }
+        slot = (slot + 1) & (index->hash_size - 1);
+    }
+    return 0;
+}
+
+static int build_case_index(case_index *index, const char *dir, int type, int64_t modified_time)
+{
+    clear_case_index(index);
+    data.building_index = index;
+    if (platform_file_manager_list_directory_contents(dir, type, 0, add_to_case_index) == LIST_MATCH) {
+        // Out of memory
+        clear_case_index(index);
+        return 0;
+    }
+    index->hash_size = 16;
+    while (index->hash_size < 2 * index->num_names) {
+        index->hash_size *= 2;
+    }
+    index->hash_table = (int *) calloc(index->hash_size, sizeof(int));
+    if (!index->hash_table) {
+        clear_case_index(index);
+        return 0;
+    }
+    for (int i = 0; i < index->num_names; i++) {
+        // When several files only differ in case, the first one listed wins, as when scanning
+        if (find_in_case_index(index, index->names[i])) {
+            continue;
+        }
+        unsigned int slot = hash_case_insensitive(index->names[i]) & (index->hash_size - 1);
+        while (index->hash_table[slot]) {
+            slot = (slot + 1) & (index->hash_size - 1);
+        }
+        index->hash_table[slot] = i + 1;
+    }
+    index->modified_time = modified_time;
+    index->needs_refresh = !modified_time || is_recently_modified(modified_time);
+    return 1;
+}
+
+static const case_index *get_case_index(const char *dir, int type)
+{
+    int64_t modified_time = platform_file_manager_get_modified_time(dir);
+    case_index *index = 0;
+    for (int i = 0; i < MAX_CASE_INDEXES; i++) {
+        case_index *current = &data.case_indexes[i];
+        if (current->dir && current->type == type && strcmp(current->dir, dir) == 0) {
+            index = current;
+            break;
+        }
+    }
+    if (!index) {
+        index = &data.case_indexes[0];
+        for (int i = 1; i < MAX_CASE_INDEXES; i++) {
+            if (data.case_indexes[i].last_used < index->last_used) {
+                index = &data.case_indexes[i];
+            }
+        }
+        clear_case_index(index);
+        free(index->dir);
+        index->dir = (char *) malloc(strlen(dir) + 1);
+        if (!index->dir) {
+            return 0;
+        }
+        strcpy(index->dir, dir);
+        index->type = type;
+    } else if (index->hash_table && !index->needs_refresh && index->modified_time == modified_time) {
+        index->last_used = ++data.case_index_uses;
+        return index;
+    }
+    index->last_used = ++data.case_index_uses;
+    return build_case_index(index, dir, type, modified_time) ? index : 0;
+}
+
 static int correct_case(const char *dir, char *filename, int type)
 {
-    data.cased_filename = filename;
-    return platform_file_manager_list_directory_contents(dir, type, 0, compare_case) == LIST_MATCH;
+    const case_index *index = get_case_index(dir, type);
+    if (!index) {
+        data.cased_filename = filename;
+        return platform_file_manager_list_directory_contents(dir, type, 0, compare_case) == LIST_MATCH;
+    }
+    const char *name = find_in_case_index(index, filename);
+    if (!name) {
+        return 0;
+    }
+    strcpy(filename, name);
+    return 1;
 }
 
 static void move_left(char *str)
@@ -4,9 +4,12 @@
 #include "core/locale.h"
 #include "core/string.h"
 
-#include <stdlib.h>
+#include <string.h>
 
 #define HIGH_CHAR_COUNT 128
+#define UTF8_LOOKUP_SIZE 256
+#define ASCII_BLOCK_SIZE 8
+#define ASCII_BLOCK_HIGH_BITS 0x8080808080808080ULL
 
 typedef struct {
     uint8_t internal_value;
@@ -21,6 +24,11 @@ typedef struct {
     const letter_code *code;
 } from_utf8_lookup;
 
+typedef struct {
+    int bytes;
+    uint8_t utf8[4];
+} to_utf8_lookup;
+
 static const letter_code HIGH_TO_UTF8_DEFAULT[HIGH_CHAR_COUNT] = {
     {0x80, 3, {0xe2, 0x82, 0xac}},
     {0x81, 1, {0x3f}},
@@ -416,10 +424,10 @@ static const letter_code HIGH_TO_UTF8_CYRILLIC[HIGH_CHAR_COUNT] = {
 
 static encoding_type encoding;
 static const letter_code *to_utf8_table;
-static from_utf8_lookup from_utf8_table[HIGH_CHAR_COUNT];
-static from_utf8_lookup from_utf8_decomposed_table[HIGH_CHAR_COUNT];
-static int utf8_table_size;
-static int decomposed_table_size;
+static to_utf8_lookup to_utf8_composed_table[HIGH_CHAR_COUNT];
+static to_utf8_lookup to_utf8_decomposed_table[HIGH_CHAR_COUNT];
+static from_utf8_lookup from_utf8_table[UTF8_LOOKUP_SIZE];
+static from_utf8_lookup from_utf8_decomposed_table[UTF8_LOOKUP_SIZE];
 
 static uint32_t calculate_utf8_value(const uint8_t *bytes, int length)
 {
@@ -439,53 +447,68 @@ static uint32_t calculate_utf8_value(const uint8_t *bytes, int length)
     return value;
 }
 
-static int compare_utf8_lookup(const void *a, const void *b)
+static unsigned int hash_utf8_value(uint32_t value)
+{
+    return (value * 2654435761u) >> 24;
+}
+
+static void add_to_lookup_table(from_utf8_lookup *table, uint32_t value, const letter_code *code)
 {
-    uint32_t va = ((const from_utf8_lookup*) a)->utf8;
-    uint32_t vb = ((const from_utf8_lookup*) b)->utf8;
-    return va == vb ? 0 : (va < vb ? -1 : 1);
+    // The table is twice the size of the number of characters, so there is always a free slot
+    unsigned int index = hash_utf8_value(value);
+    while (table[index].code) {
+        if (table[index].utf8 == value) {
+            return;
+        }
+        index = (index + 1) & (UTF8_LOOKUP_SIZE - 1);
+    }
+    table[index].utf8 = value;
+    table[index].code = code;
 }
 
 static void build_reverse_lookup_table(void)
 {
+    memset(from_utf8_table, 0, sizeof(from_utf8_table));
     if (!to_utf8_table) {
-        utf8_table_size = 0;
         return;
     }
     for (int i = 0; i < HIGH_CHAR_COUNT; i++) {
         const letter_code *code = &to_utf8_table[i];
-        from_utf8_table[i].code = code;
-        from_utf8_table[i].utf8 = calculate_utf8_value(code->utf8_value, code->bytes);
+        add_to_lookup_table(from_utf8_table, calculate_utf8_value(code->utf8_value, code->bytes), code);
     }
-    utf8_table_size = HIGH_CHAR_COUNT;
-    qsort(from_utf8_table, utf8_table_size, sizeof(from_utf8_lookup), compare_utf8_lookup);
 }
 
 static void build_decomposed_lookup_table(void)
 {
+    memset(from_utf8_decomposed_table, 0, sizeof(from_utf8_decomposed_table));
     if (!to_utf8_table) {
-        decomposed_table_size = 0;
         return;
     }
-    int index = 0;
     for (int i = 0; i < HIGH_CHAR_COUNT; i++) {
         const letter_code *code = &to_utf8_table[i];
         if (code->bytes_decomposed > 0) {
-            from_utf8_decomposed_table[index].code = code;
-            from_utf8_decomposed_table[index].utf8 = calculate_utf8_value(code->utf8_decomposed, code->bytes_decomposed);
-            index++;
+            add_to_lookup_table(from_utf8_decomposed_table,
+                calculate_utf8_value(code->utf8_decomposed, code->bytes_decomposed), code);
         }
     }
-    decomposed_table_size = index;
-    qsort(from_utf8_decomposed_table, decomposed_table_size, sizeof(from_utf8_lookup), compare_utf8_lookup);
 }
 
-static const letter_code* get_letter_code_for_internal(uint8_t c)
+static void build_forward_lookup_tables(void)
 {
-    if (c < 0x80 || !to_utf8_table) {
-        return NULL;
+    if (!to_utf8_table) {
+        return;
+    }
+    for (int i = 0; i < HIGH_CHAR_COUNT; i++) {
+        const letter_code *code = &to_utf8_table[i];
+        to_utf8_composed_table[i].bytes = code->bytes;
+        memcpy(to_utf8_composed_table[i].utf8, code->utf8_value, sizeof(code->utf8_value));
+        if (code->bytes_decomposed) {
+            to_utf8_decomposed_table[i].bytes = code->bytes_decomposed;
+            memcpy(to_utf8_decomposed_table[i].utf8, code->utf8_decomposed, sizeof(code->utf8_decomposed));
+        } else {
+            to_utf8_decomposed_table[i] = to_utf8_composed_table[i];
+        }
     }
-    return &to_utf8_table[c - 0x80];
 }
 
 static int get_utf8_code(const char *c, int *num_bytes)
@@ -516,16 +539,22 @@ static int is_combining_char(uint8_t b1, uint8_t b2)
     return 0;
 }
 
-static const letter_code* search_utf8_table(const from_utf8_lookup *key, const from_utf8_lookup *table, int size)
+static const letter_code* search_utf8_table(uint32_t value, const from_utf8_lookup *table)
 {
-    const from_utf8_lookup *result = bsearch(key, table, size, sizeof(from_utf8_lookup), compare_utf8_lookup);
-    return result ? result->code : NULL;
+    unsigned int index = hash_utf8_value(value);
+    while (table[index].code) {
+        if (table[index].utf8 == value) {
+            return table[index].code;
+        }
+        index = (index + 1) & (UTF8_LOOKUP_SIZE - 1);
+    }
+    return NULL;
 }
 
 static const letter_code* get_letter_code_for_utf8(const char *c, int *num_bytes, int *is_accent)
 {
     static letter_code single_char = {0, 1};
-    from_utf8_lookup key = {0, NULL};
+    uint32_t value = 0;
     if (is_accent) *is_accent = 0;
     const uint8_t *uc = (const uint8_t *) c;
 
@@ -537,7 +566,7 @@ static const letter_code* get_letter_code_for_utf8(const char *c, int *num_bytes
     } else if ((uc[0] & 0xe0) == 0xc0 && (uc[1] & 0xc0) == 0x80) {
         // 2-byte character
         if (num_bytes) *num_bytes = 2;
-        key.utf8 = uc[0] | uc[1] << 8;
+        value = uc[0] | uc[1] << 8;
         if (is_combining_char(uc[0], uc[1])) {
             if (is_accent) *is_accent = 1;
             return NULL;
@@ -545,14 +574,14 @@ static const letter_code* get_letter_code_for_utf8(const char *c, int *num_bytes
     } else if ((uc[0] & 0xf0) == 0xe0 && (uc[1] & 0xc0) == 0x80 && (uc[2] & 0xc0) == 0x80) {
         // 3-byte character
         if (num_bytes) *num_bytes = 3;
-        key.utf8 = uc[0] | uc[1] << 8 | uc[2] << 16;
+        value = uc[0] | uc[1] << 8 | uc[2] << 16;
     } else {
         if (num_bytes) *num_bytes = 1;
     }
-    if (key.utf8 == 0) {
+    if (value == 0) {
         return NULL;
     }
-    return search_utf8_table(&key, from_utf8_table, utf8_table_size);
+    return search_utf8_table(value, from_utf8_table);
 }
 
 static const letter_code* get_letter_code_for_combining_utf8(const char *prev_char, const char *combining_char)
@@ -568,8 +597,7 @@ static const letter_code* get_letter_code_for_combining_utf8(const char *prev_ch
     }
     code |= prev_code;
 
-    from_utf8_lookup key = {code};
-    return search_utf8_table(&key, from_utf8_decomposed_table, decomposed_table_size);
+    return search_utf8_table(code, from_utf8_decomposed_table);
 }
 
 encoding_type encoding_determine(void)
@@ -596,6 +624,7 @@ encoding_type encoding_determine(void)
         to_utf8_table = HIGH_TO_UTF8_DEFAULT;
         encoding = ENCODING_WESTERN_EUROPE;
     }
+    build_forward_lookup_tables();
     build_reverse_lookup_table();
     build_decomposed_lookup_table();
     return encoding;
@@ -616,6 +645,21 @@ int encoding_can_display(const char *utf8_char)
     return is_ascii(utf8_char) || get_letter_code_for_utf8(utf8_char, NULL, NULL) != NULL;
 }
 
+static int copy_ascii_blocks(const void *input, int input_length, void *output, int output_length)
+{
+    int copied = 0;
+    while (copied + ASCII_BLOCK_SIZE <= input_length && copied + ASCII_BLOCK_SIZE <= output_length) {
+        uint64_t block;
+        memcpy(&block, (const uint8_t *) input + copied, ASCII_BLOCK_SIZE);
+        if (block & ASCII_BLOCK_HIGH_BITS) {
+            break;
+        }
+        memcpy((uint8_t *) output + copied, &block, ASCII_BLOCK_SIZE);
+        copied += ASCII_BLOCK_SIZE;
+    }
+    return copied;
+}
+
 void encoding_to_utf8(const uint8_t *input, char *output, int output_length, int decomposed)
 {
     if (!to_utf8_table) {
@@ -623,30 +667,32 @@ void encoding_to_utf8(const uint8_t *input, char *output, int output_length, int
         return;
     }
     const char *max_output = &output[output_length - 1];
-    
+    const uint8_t *input_end = input + strlen((const char *) input);
+    const uint8_t *next_ascii_block = input;
+    const to_utf8_lookup *table = decomposed ? to_utf8_decomposed_table : to_utf8_composed_table;
+
     while (*input && output < max_output) {
         uint8_t c = *input;
+        if (c < 0x80 && input >= next_ascii_block) {
+            int ascii_bytes = copy_ascii_blocks(input, (int) (input_end - input), output, (int) (max_output - output));
+            input += ascii_bytes;
+            output += ascii_bytes;
+            // The next block contains a non-ASCII character, don't try again until past it
+            next_ascii_block = input + ASCII_BLOCK_SIZE;
+            continue;
+        }
         if (c < 0x80) {
             *output = c;
             ++output;
         } else {
             // multi-byte char
-            const letter_code *code = get_letter_code_for_internal(c);
-            int num_bytes;
-            const uint8_t *bytes;
-            if (decomposed && code->bytes_decomposed) {
-                num_bytes = code->bytes_decomposed;
-                bytes = code->utf8_decomposed;
-            } else {
-                num_bytes = code->bytes;
-                bytes = code->utf8_value;
-            }
-            if (num_bytes) {
-                if (output + num_bytes >= max_output) {
+            const to_utf8_lookup *code = &table[c - 0x80];
+            if (code->bytes) {
+                if (output + code->bytes >= max_output) {
                     break;
                 }
-                for (int i = 0; i < num_bytes; i++) {
-                    *output = bytes[i];
+                for (int i = 0; i < code->bytes; i++) {
+                    *output = code->utf8[i];
                     ++output;
                 }
             }
@@ -659,9 +705,22 @@ void encoding_to_utf8(const uint8_t *input, char *output, int output_length, int
 void encoding_from_utf8(const char *input, uint8_t *output, int output_length)
 {
     const uint8_t *max_output = &output[output_length - 1];
+    const char *input_end = input + strlen(input);
+    const char *next_ascii_block = input;
 
     const char *prev_input = input;
     while (*input && output < max_output) {
+        if (is_ascii(input) && input >= next_ascii_block) {
+            int ascii_bytes = copy_ascii_blocks(input, (int) (input_end - input), output, (int) (max_output - output));
+            if (ascii_bytes) {
+                input += ascii_bytes;
+                output += ascii_bytes;
+                prev_input = input - 1;
+            }
+            // The next block contains a non-ASCII character, don't try again until past it
+            next_ascii_block = input + ASCII_BLOCK_SIZE;
+            continue;
+        }
         if (is_ascii(input)) {
             *output = *input;
             prev_input = input;
@@ -77,4 +77,19 @@ int file_exists(const char *filename, int localizable);
  */
 int file_remove(const char *filename);
 
+/**
+ * Rename a file, replacing the destination if it exists
+ * @param filename Filename to rename
+ * @param new_filename New filename
+ * @return boolean true if the file was renamed, false otherwise
+ */
+int file_rename(const char *filename, const char *new_filename);
+
+/**
+ * Get the last modification time of a file
+ * @param filename Filename to check
+ * @return Modification time in seconds since the epoch, 0 if the file does not exist
+ */
+int64_t file_modified_time(const char *filename);
+
 #endif // CORE_FILE_H
@@ -121,6 +121,8 @@ static const image DUMMY_IMAGE;
 static struct {
     int current_climate;
     int is_editor;
+    int current_enemy;
+    int letters_version;
     int fonts_enabled;
     int font_base_offset;
 
@@ -134,7 +136,7 @@ static struct {
     color_t *enemy_data;
     color_t *font_data;
     uint8_t *tmp_data;
-} data = {.current_climate = -1};
+} data = {.current_climate = -1, .current_enemy = -1};
 
 int image_init(void)
 {
@@ -298,6 +300,10 @@ int image_load_climate(int climate_id, int is_editor, int force_reload)
     if (climate_id == data.current_climate && is_editor == data.is_editor && !force_reload) {
         return 1;
     }
+    if (force_reload) {
+        // localized enemy graphics may have changed as well
+        data.current_enemy = -1;
+    }
 
     const char *filename_bmp = is_editor ? EDITOR_GRAPHICS_555[climate_id] : MAIN_GRAPHICS_555[climate_id];
     const char *filename_idx = is_editor ? EDITOR_GRAPHICS_SG2[climate_id] : MAIN_GRAPHICS_SG2[climate_id];
@@ -320,6 +326,7 @@ int image_load_climate(int climate_id, int is_editor, int force_reload)
     convert_images(data.main, MAIN_ENTRIES, &buf, data.main_data);
     data.current_climate = climate_id;
     data.is_editor = is_editor;
+    data.letters_version++;
 
     load_empire();
     return 1;
@@ -498,6 +505,7 @@ static int load_korean_fonts(void)
 
 int image_load_fonts(encoding_type encoding)
 {
+    data.letters_version++;
     if (encoding == ENCODING_CYRILLIC) {
         return load_cyrillic_fonts();
     } else if (encoding == ENCODING_TRADITIONAL_CHINESE) {
@@ -510,11 +518,24 @@ int image_load_fonts(encoding_type encoding)
     }
 }
 
+int image_letters_version(void)
+{
+    return data.letters_version;
+}
+
 int image_load_enemy(int enemy_id)
 {
     const char *filename_bmp = ENEMY_GRAPHICS_555[enemy_id];
     const char *filename_idx = ENEMY_GRAPHICS_SG2[enemy_id];
 
+    // several enemies share the same graphics files
+    if (data.current_enemy >= 0 &&
+        strcmp(filename_bmp, ENEMY_GRAPHICS_555[data.current_enemy]) == 0 &&
+        strcmp(filename_idx, ENEMY_GRAPHICS_SG2[data.current_enemy]) == 0) {
+        return 1;
+    }
+    data.current_enemy = -1;
+
     if (ENEMY_INDEX_SIZE != io_read_file_part_into_buffer(filename_idx, MAY_BE_LOCALIZED, data.tmp_data, ENEMY_INDEX_SIZE, ENEMY_INDEX_OFFSET)) {
         return 0;
     }
@@ -529,6 +550,7 @@ int image_load_enemy(int enemy_id)
     }
     buffer_init(&buf, data.tmp_data, data_size);
     convert_images(data.enemy, ENEMY_ENTRIES, &buf, data.enemy_data);
+    data.current_enemy = enemy_id;
     return 1;
 }
 
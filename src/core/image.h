@@ -63,7 +63,15 @@ int image_load_climate(int climate_id, int is_editor, int force_reload);
 int image_load_fonts(encoding_type encoding);
 
 /**
- * Loads the image collection for the specified enemy
+ * Returns a number that changes whenever the images of letters may have changed,
+ * for caches of drawn text
+ * @return Version of the letter images
+ */
+int image_letters_version(void);
+
+/**
+ * Loads the image collection for the specified enemy.
+ * Does nothing when the graphics of that enemy are already loaded
  * @param enemy_id Enemy to load
  * @return boolean true on success, false on failure
  */
@@ -1,8 +1,8 @@
 #include "core/lang.h"
 
 #include "core/buffer.h"
+#include "core/dir.h"
 #include "core/file.h"
-#include "core/io.h"
 #include "core/string.h"
 
 #include <stdlib.h>
@@ -18,7 +18,7 @@
 #define MIN_MESSAGE_SIZE 32024
 #define MAX_MESSAGE_SIZE (MIN_MESSAGE_SIZE + MAX_MESSAGE_DATA)
 
-#define BUFFER_SIZE 400000
+#define MESSAGE_ENTRY_SIZE 80
 
 #define FILE_TEXT_ENG "c3.eng"
 #define FILE_MM_ENG "c3_mm.eng"
@@ -27,14 +27,23 @@
 #define FILE_EDITOR_TEXT_ENG "c3_map.eng"
 #define FILE_EDITOR_MM_ENG "c3_map_mm.eng"
 
+typedef struct {
+    int32_t *offsets;
+    int num_offsets;
+    int capacity;
+} string_index;
+
 static struct {
     struct {
         int32_t offset;
         int32_t in_use;
     } text_entries[MAX_TEXT_ENTRIES];
     uint8_t text_data[MAX_TEXT_DATA];
+    string_index strings[MAX_TEXT_ENTRIES];
 
+    uint8_t message_header[MIN_MESSAGE_SIZE];
     lang_message message_entries[MAX_MESSAGE_ENTRIES];
+    int message_parsed[MAX_MESSAGE_ENTRIES];
     uint8_t message_data[MAX_MESSAGE_DATA];
 } data;
 
@@ -59,28 +68,67 @@ int lang_dir_is_valid(const char *dir)
     return 0;
 }
 
-static void parse_text(buffer *buf)
+static FILE *open_file(const char *filename, int localizable, int *size)
 {
-    buffer_skip(buf, 28); // header
-    for (int i = 0; i < MAX_TEXT_ENTRIES; i++) {
-        data.text_entries[i].offset = buffer_read_i32(buf);
-        data.text_entries[i].in_use = buffer_read_i32(buf);
+    const char *cased_file = dir_get_file(filename, localizable);
+    if (!cased_file) {
+        return 0;
     }
-    buffer_read_raw(buf, data.text_data, MAX_TEXT_DATA);
+    FILE *fp = file_open(cased_file, "rb");
+    if (!fp) {
+        return 0;
+    }
+    fseek(fp, 0, SEEK_END);
+    *size = (int) ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    return fp;
 }
 
-static int load_text(const char *filename, int localizable, uint8_t *buf_data)
+static int read_data(FILE *fp, uint8_t *dst, int size, int max_size)
 {
-    buffer buf;
-    int filesize = io_read_file_into_buffer(filename, localizable, buf_data, BUFFER_SIZE);
-    if (filesize < MIN_TEXT_SIZE || filesize > MAX_TEXT_SIZE) {
+    if ((int) fread(dst, 1, size, fp) != size) {
         return 0;
     }
-    buffer_init(&buf, buf_data, filesize);
-    parse_text(&buf);
+    memset(&dst[size], 0, max_size - size);
     return 1;
 }
 
+static void clear_string_index(void)
+{
+    for (int i = 0; i < MAX_TEXT_ENTRIES; i++) {
+        free(data.strings[i].offsets);
+        data.strings[i].offsets = 0;
+        data.strings[i].num_offsets = 0;
+        data.strings[i].capacity = 0;
+    }
+}
+
+static int load_text(const char *filename, int localizable)
+{
+    int filesize;
+    FILE *fp = open_file(filename, localizable, &filesize);
+    if (!fp) {
+        return 0;
+    }
+    int success = 0;
+    // The header is read into the message header buffer, which is filled when loading messages
+    uint8_t *header = data.message_header;
+    if (filesize >= MIN_TEXT_SIZE && filesize <= MAX_TEXT_SIZE &&
+        fread(header, 1, MIN_TEXT_SIZE, fp) == MIN_TEXT_SIZE) {
+        buffer buf;
+        buffer_init(&buf, header, MIN_TEXT_SIZE);
+        buffer_skip(&buf, 28); // header
+        for (int i = 0; i < MAX_TEXT_ENTRIES; i++) {
+            data.text_entries[i].offset = buffer_read_i32(&buf);
+            data.text_entries[i].in_use = buffer_read_i32(&buf);
+        }
+        success = read_data(fp, data.text_data, filesize - MIN_TEXT_SIZE, MAX_TEXT_DATA);
+        clear_string_index();
+    }
+    file_close(fp);
+    return success;
+}
+
 static uint8_t *get_message_text(int32_t offset)
 {
     if (!offset) {
@@ -89,62 +137,64 @@ static uint8_t *get_message_text(int32_t offset)
     return &data.message_data[offset];
 }
 
-static void parse_message(buffer *buf)
+static void parse_message(int id)
 {
-    buffer_skip(buf, 24); // header
-    for (int i = 0; i < MAX_MESSAGE_ENTRIES; i++) {
-        lang_message *m = &data.message_entries[i];
-        m->type = buffer_read_i16(buf);
-        m->message_type = buffer_read_i16(buf);
-        buffer_skip(buf, 2);
-        m->x = buffer_read_i16(buf);
-        m->y = buffer_read_i16(buf);
-        m->width_blocks = buffer_read_i16(buf);
-        m->height_blocks = buffer_read_i16(buf);
-        m->image.id = buffer_read_i16(buf);
-        m->image.x = buffer_read_i16(buf);
-        m->image.y = buffer_read_i16(buf);
-        buffer_skip(buf, 6); // unused image2 id, x, y
-        m->title.x = buffer_read_i16(buf);
-        m->title.y = buffer_read_i16(buf);
-        m->subtitle.x = buffer_read_i16(buf);
-        m->subtitle.y = buffer_read_i16(buf);
-        buffer_skip(buf, 4);
-        m->video.x = buffer_read_i16(buf);
-        m->video.y = buffer_read_i16(buf);
-        buffer_skip(buf, 14);
-        m->urgent = buffer_read_i32(buf);
-        
-        m->video.text = get_message_text(buffer_read_i32(buf));
-        buffer_skip(buf, 4);
-        m->title.text = get_message_text(buffer_read_i32(buf));
-        m->subtitle.text = get_message_text(buffer_read_i32(buf));
-        m->content.text = get_message_text(buffer_read_i32(buf));
-    }
-    buffer_read_raw(buf, &data.message_data, MAX_MESSAGE_DATA);
+    buffer buf;
+    buffer_init(&buf, &data.message_header[24 + id * MESSAGE_ENTRY_SIZE], MESSAGE_ENTRY_SIZE);
+    lang_message *m = &data.message_entries[id];
+    m->type = buffer_read_i16(&buf);
+    m->message_type = buffer_read_i16(&buf);
+    buffer_skip(&buf, 2);
+    m->x = buffer_read_i16(&buf);
+    m->y = buffer_read_i16(&buf);
+    m->width_blocks = buffer_read_i16(&buf);
+    m->height_blocks = buffer_read_i16(&buf);
+    m->image.id = buffer_read_i16(&buf);
+    m->image.x = buffer_read_i16(&buf);
+    m->image.y = buffer_read_i16(&buf);
+    buffer_skip(&buf, 6); // unused image2 id, x, y
+    m->title.x = buffer_read_i16(&buf);
+    m->title.y = buffer_read_i16(&buf);
+    m->subtitle.x = buffer_read_i16(&buf);
+    m->subtitle.y = buffer_read_i16(&buf);
+    buffer_skip(&buf, 4);
+    m->video.x = buffer_read_i16(&buf);
+    m->video.y = buffer_read_i16(&buf);
+    buffer_skip(&buf, 14);
+    m->urgent = buffer_read_i32(&buf);
+
+    m->video.text = get_message_text(buffer_read_i32(&buf));
+    buffer_skip(&buf, 4);
+    m->title.text = get_message_text(buffer_read_i32(&buf));
+    m->subtitle.text = get_message_text(buffer_read_i32(&buf));
+    m->content.text = get_message_text(buffer_read_i32(&buf));
+    data.message_parsed[id] = 1;
 }
 
-static int load_message(const char *filename, int localizable, uint8_t *data_buffer)
+static int load_message(const char *filename, int localizable)
 {
-    buffer buf;
-    int filesize = io_read_file_into_buffer(filename, localizable, data_buffer, BUFFER_SIZE);
-    if (filesize < MIN_MESSAGE_SIZE || filesize > MAX_MESSAGE_SIZE) {
+    int filesize;
+    FILE *fp = open_file(filename, localizable, &filesize);
+    if (!fp) {
         return 0;
     }
-    buffer_init(&buf, data_buffer, filesize);
-    parse_message(&buf);
-    return 1;
+    int success = 0;
+    if (filesize > MAX_MESSAGE_SIZE) {
+        filesize = MAX_MESSAGE_SIZE;
+    }
+    if (filesize >= MIN_MESSAGE_SIZE &&
+        fread(data.message_header, 1, MIN_MESSAGE_SIZE, fp) == MIN_MESSAGE_SIZE) {
+        // Entries are parsed when they are first used
+        memset(data.message_parsed, 0, sizeof(data.message_parsed));
+        success = read_data(fp, data.message_data, filesize - MIN_MESSAGE_SIZE, MAX_MESSAGE_DATA);
+    }
+    file_close(fp);
+    return success;
 }
 
 static int load_files(const char *text_filename, const char *message_filename, int localizable)
 {
-    uint8_t *buffer = (uint8_t *) malloc(BUFFER_SIZE);
-    if (!buffer) {
-        return 0;
-    }
-    int success = load_text(text_filename, localizable, buffer) && load_message(message_filename, localizable, buffer);
-    free(buffer);
-    return success;
+    return load_text(text_filename, localizable) && load_message(message_filename, localizable);
 }
 
 int lang_load(int is_editor)
@@ -160,24 +210,73 @@ int lang_load(int is_editor)
         load_files(FILE_TEXT_RUS, FILE_MM_RUS, NOT_LOCALIZED);
 }
 
-const uint8_t *lang_get_string(int group, int index)
+static int find_next_string(int offset)
 {
-    const uint8_t *str = &data.text_data[data.text_entries[group].offset];
     uint8_t prev = 0;
-    while (index > 0) {
-        if (!*str && (prev >= ' ' || prev == 0)) {
-            --index;
+    while (offset >= 0 && offset < MAX_TEXT_DATA) {
+        uint8_t c = data.text_data[offset++];
+        if (!c && (prev >= ' ' || prev == 0)) {
+            return offset;
         }
-        prev = *str;
-        ++str;
+        prev = c;
     }
-    while (*str < ' ') { // skip non-printables
-        ++str;
+    return -1;
+}
+
+static int find_string(int group, int index)
+{
+    string_index *strings = &data.strings[group];
+    if (index < strings->num_offsets) {
+        return strings->offsets[index];
+    }
+    if (index >= strings->capacity) {
+        int capacity = strings->capacity ? strings->capacity : 16;
+        while (capacity <= index) {
+            capacity *= 2;
+        }
+        int32_t *offsets = (int32_t *) realloc(strings->offsets, sizeof(int32_t) * capacity);
+        if (offsets) {
+            strings->offsets = offsets;
+            strings->capacity = capacity;
+        }
+    }
+    int offset;
+    int current;
+    if (strings->num_offsets) {
+        current = strings->num_offsets - 1;
+        offset = strings->offsets[current];
+    } else {
+        current = 0;
+        offset = data.text_entries[group].offset;
+    }
+    while (1) {
+        if (current < strings->capacity && current == strings->num_offsets) {
+            strings->offsets[strings->num_offsets++] = offset;
+        }
+        if (current == index || offset < 0) {
+            return offset;
+        }
+        offset = find_next_string(offset);
+        current++;
     }
-    return str;
+}
+
+const uint8_t *lang_get_string(int group, int index)
+{
+    int offset = find_string(group, index);
+    while (offset >= 0 && offset < MAX_TEXT_DATA && data.text_data[offset] < ' ') { // skip non-printables
+        offset++;
+    }
+    if (offset < 0 || offset >= MAX_TEXT_DATA) {
+        return (const uint8_t *) "";
+    }
+    return &data.text_data[offset];
 }
 
 const lang_message *lang_get_message(int id)
 {
+    if (!data.message_parsed[id]) {
+        parse_message(id);
+    }
     return &data.message_entries[id];
 }
@@ -30,36 +30,44 @@
 #define BLOCK_VOID 2
 #define BLOCK_SOLID 3
 
+#define TREE8_MAX_NODES 512
+#define TREE8_TABLE_BITS 8
+#define TREE16_TABLE_BITS 12
+
 typedef struct {
     const uint8_t *data;
     int length;
     int index;
-    int bit_index;
+    uint64_t buffer;
+    int bits;
 } bitstream;
 
-typedef struct huffnode8_t {
-    struct huffnode8_t *b[2];
+typedef struct {
+    int32_t b[2];
     int is_leaf;
-    uint8_t value;
-} huffnode8;
+    uint16_t value;
+} huffnode;
 
-typedef struct hufftree8_t {
-    huffnode8 nodes[512];
+/**
+ * Huffman trees are stored as arrays of nodes, with a lookup table that is indexed by the next bits
+ * in the stream. Each table entry holds the node those bits lead to in the upper bits, and the
+ * number of bits used in the lower four bits. Codes longer than the table are finished bit by bit.
+ */
+typedef struct {
+    huffnode nodes[TREE8_MAX_NODES];
     int size;
+    uint32_t table[1 << TREE8_TABLE_BITS];
 } hufftree8;
 
-typedef struct huffnode16_t {
-    struct huffnode16_t *b[2];
-    int is_leaf;
-    uint16_t value;
-} huffnode16;
-
-typedef struct hufftree16_t {
-    huffnode16 *root;
+typedef struct {
+    huffnode *nodes;
+    int size;
+    int capacity;
+    uint32_t *table;
     hufftree8 *low;
     hufftree8 *high;
     uint16_t escape_codes[3];
-    huffnode16 *escape_nodes[3];
+    int32_t escape_nodes[3];
 } hufftree16;
 
 typedef struct {
@@ -85,6 +93,7 @@ struct smacker_t {
     long *frame_offsets;
     int32_t *frame_sizes;
     uint8_t *frame_types;
+    int32_t max_frame_size;
 
     hufftree16 *mmap_tree;
     hufftree16 *mclr_tree;
@@ -92,21 +101,10 @@ struct smacker_t {
     hufftree16 *type_tree;
 
     frame_data_t frame_data;
+    uint8_t *frame_buffer;
     int32_t current_frame;
 };
 
-static const uint8_t BIT_MASKS[] = {
-    0x00,
-    0x01,
-    0x03,
-    0x07,
-    0x0f,
-    0x1f,
-    0x3f,
-    0x7f,
-    0xff,
-};
-
 static const uint8_t PALETTE_MAP[64] = {
     0x00, 0x04, 0x08, 0x0C, 0x10, 0x14, 0x18, 0x1C,
     0x20, 0x24, 0x28, 0x2C, 0x30, 0x34, 0x38, 0x3C,
@@ -150,72 +148,141 @@ static bitstream *bitstream_init(bitstream *bs, const uint8_t *data, int len)
     bs->data = data;
     bs->length = len;
     bs->index = 0;
-    bs->bit_index = 0;
+    bs->buffer = 0;
+    bs->bits = 0;
     return bs;
 }
 
-static inline int read_bit(bitstream *bs)
+static inline void refill(bitstream *bs)
 {
-    if (bs->index >= bs->length) {
-        return 0;
+    if (bs->index + 8 <= bs->length) {
+        const uint8_t *data = &bs->data[bs->index];
+        uint64_t value = (uint64_t) data[0] | (uint64_t) data[1] << 8 |
+            (uint64_t) data[2] << 16 | (uint64_t) data[3] << 24 |
+            (uint64_t) data[4] << 32 | (uint64_t) data[5] << 40 |
+            (uint64_t) data[6] << 48 | (uint64_t) data[7] << 56;
+        bs->buffer |= value << bs->bits;
+        int bytes = (63 - bs->bits) >> 3;
+        bs->index += bytes;
+        bs->bits += bytes * 8;
+    } else {
+        // Past the end of the data, the stream reads as zeroes
+        while (bs->bits <= 56) {
+            uint64_t value = bs->index < bs->length ? bs->data[bs->index] : 0;
+            bs->buffer |= value << bs->bits;
+            bs->index++;
+            bs->bits += 8;
+        }
     }
-    int result = bs->data[bs->index] & (1 << bs->bit_index);
-    if (++bs->bit_index >= 8) {
-        bs->index++;
-        bs->bit_index = 0;
+}
+
+static inline void skip_bits(bitstream *bs, int bits)
+{
+    bs->buffer >>= bits;
+    bs->bits -= bits;
+}
+
+static inline int read_bit(bitstream *bs)
+{
+    if (bs->bits == 0) {
+        refill(bs);
     }
-    return result ? 1 : 0;
+    int result = bs->buffer & 1;
+    skip_bits(bs, 1);
+    return result;
 }
 
 static inline uint8_t read_byte(bitstream *bs)
 {
-    if (bs->bit_index == 0) {
+    int bit_position = bs->index * 8 - bs->bits;
+    int byte_index = bit_position >> 3;
+    if ((bit_position & 7) == 0) {
         // special case: on exact byte boundary
-        if (bs->index < bs->length) {
-            return bs->data[bs->index++];
-        } else {
+        if (byte_index >= bs->length) {
             return 0;
         }
-    }
-    if (bs->index + 1 >= bs->length) {
+    } else if (byte_index + 1 >= bs->length) {
         return 0;
     }
-    uint8_t value = bs->data[bs->index] >> bs->bit_index;
-    bs->index++;
-    value |= (bs->data[bs->index] & BIT_MASKS[bs->bit_index]) << (8 - bs->bit_index);
+    if (bs->bits < 8) {
+        refill(bs);
+    }
+    uint8_t value = bs->buffer & 0xff;
+    skip_bits(bs, 8);
     return value;
 }
 
+// Huffman table functions
+
+static void fill_table(const huffnode *nodes, int node, int depth, uint32_t code, uint32_t *table, int table_bits)
+{
+    if (nodes[node].is_leaf || depth == table_bits) {
+        uint32_t entry = ((uint32_t) node << 4) | depth;
+        for (uint32_t i = code; i < (1u << table_bits); i += 1u << depth) {
+            table[i] = entry;
+        }
+    } else {
+        fill_table(nodes, nodes[node].b[0], depth + 1, code, table, table_bits);
+        fill_table(nodes, nodes[node].b[1], depth + 1, code | (1u << depth), table, table_bits);
+    }
+}
+
+static inline int lookup_node(bitstream *bs, const huffnode *nodes, const uint32_t *table, int table_bits)
+{
+    if (bs->bits < table_bits) {
+        refill(bs);
+    }
+    uint32_t entry = table[bs->buffer & ((1u << table_bits) - 1)];
+    skip_bits(bs, entry & 0xf);
+    int node = entry >> 4;
+    while (!nodes[node].is_leaf) {
+        node = nodes[node].b[read_bit(bs)];
+    }
+    return node;
+}
+
 // 8-bit huffman tree functions
 
-static huffnode8 *build_tree8_nodes(bitstream *bs, hufftree8 *tree)
+static int build_tree8_nodes(bitstream *bs, hufftree8 *tree)
 {
-    huffnode8 *node = &tree->nodes[tree->size++];
+    if (tree->size >= TREE8_MAX_NODES) {
+        log_error("SMK: 8-bit tree too large", 0, 0);
+        return -1;
+    }
+    int index = tree->size++;
+    huffnode *node = &tree->nodes[index];
     if (read_bit(bs)) {
         node->is_leaf = 0;
-        node->b[0] = build_tree8_nodes(bs, tree);
-        node->b[1] = build_tree8_nodes(bs, tree);
+        if ((node->b[0] = build_tree8_nodes(bs, tree)) < 0 ||
+            (node->b[1] = build_tree8_nodes(bs, tree)) < 0) {
+            return -1;
+        }
     } else {
         node->is_leaf = 1;
         node->value = read_byte(bs);
     }
-    return node;
+    return index;
 }
 
 static hufftree8 *create_tree8(bitstream *bs)
 {
     if (read_bit(bs)) {
-        hufftree8 *tree = (hufftree8 *) clear_malloc(sizeof(hufftree8));
+        hufftree8 *tree = (hufftree8 *) malloc(sizeof(hufftree8));
         if (!tree) {
             log_error("SMK: no memory for 8-bit tree", 0, 0);
             return NULL;
         }
-        build_tree8_nodes(bs, tree);
+        tree->size = 0;
+        if (build_tree8_nodes(bs, tree) < 0) {
+            free(tree);
+            return NULL;
+        }
         if (read_bit(bs) != 0) {
             log_error("SMK: 8-bit tree not closed", 0, 0);
             free(tree);
             return NULL;
         }
+        fill_table(tree->nodes, 0, 0, 0, tree->table, TREE8_TABLE_BITS);
         return tree;
     } else {
         log_info("SMK: WARN: no 8-bit tree found", 0, 0);
@@ -228,80 +295,76 @@ static void free_tree8(hufftree8 *tree)
     free(tree);
 }
 
-static uint8_t lookup_tree8(bitstream *bs, hufftree8 *tree)
+static inline uint8_t lookup_tree8(bitstream *bs, const hufftree8 *tree)
 {
-    huffnode8 *node = &tree->nodes[0];
-    while (!node->is_leaf) {
-        node = node->b[read_bit(bs)];
-    }
-    return node->value;
+    return (uint8_t) tree->nodes[lookup_node(bs, tree->nodes, tree->table, TREE8_TABLE_BITS)].value;
 }
 
 // 16-bit huffman tree functions
 
-static void free_node16(huffnode16 *node)
-{
-    if (!node) {
-        return;
-    }
-    if (!node->is_leaf) {
-        free_node16(node->b[0]);
-        free_node16(node->b[1]);
-    }
-    free(node);
-}
-
 static void free_tree16(hufftree16 *tree)
 {
     if (!tree) {
         return;
     }
-    for (int i = 0; i < 3; i++) {
-        if (!tree->escape_nodes[i]->is_leaf) {
-            // Free manually allocated node because it's not in the tree
-            free(tree->escape_nodes[i]);
-        }
-    }
-    free_node16(tree->root);
+    free(tree->nodes);
+    free(tree->table);
     free_tree8(tree->low);
     free_tree8(tree->high);
     free(tree);
 }
 
-static huffnode16 *build_tree16_nodes(bitstream *bs, hufftree16 *tree)
+static int add_node16(hufftree16 *tree)
 {
-    huffnode16 *node = (huffnode16 *) clear_malloc(sizeof(huffnode16));
-    if (!node) {
-        log_error("SMK: no memory for 16-bit tree node", 0, 0);
-        return NULL;
+    if (tree->size >= tree->capacity) {
+        int capacity = tree->capacity ? tree->capacity * 2 : 256;
+        huffnode *nodes = (huffnode *) realloc(tree->nodes, sizeof(huffnode) * capacity);
+        if (!nodes) {
+            log_error("SMK: no memory for 16-bit tree node", 0, 0);
+            return -1;
+        }
+        tree->nodes = nodes;
+        tree->capacity = capacity;
+    }
+    huffnode *node = &tree->nodes[tree->size];
+    node->b[0] = node->b[1] = 0;
+    node->is_leaf = 0;
+    node->value = 0;
+    return tree->size++;
+}
+
+static int build_tree16_nodes(bitstream *bs, hufftree16 *tree)
+{
+    int index = add_node16(tree);
+    if (index < 0) {
+        return -1;
     }
     if (read_bit(bs)) {
-        node->is_leaf = 0;
-        node->b[0] = build_tree16_nodes(bs, tree);
-        if (!node->b[0]) {
-            free(node);
-            return NULL;
+        // Children are added after this node, so the nodes array may move in between
+        int child = build_tree16_nodes(bs, tree);
+        if (child < 0) {
+            return -1;
         }
-        node->b[1] = build_tree16_nodes(bs, tree);
-        if (!node->b[1]) {
-            free_node16(node->b[0]);
-            free(node);
-            return NULL;
+        tree->nodes[index].b[0] = child;
+        child = build_tree16_nodes(bs, tree);
+        if (child < 0) {
+            return -1;
         }
+        tree->nodes[index].b[1] = child;
     } else {
-        node->is_leaf = 1;
         uint8_t lo_val = lookup_tree8(bs, tree->low);
         uint8_t hi_val = lookup_tree8(bs, tree->high);
         uint16_t leaf_value = lo_val | (hi_val << 8);
-        node->value = leaf_value;
+        tree->nodes[index].is_leaf = 1;
+        tree->nodes[index].value = leaf_value;
 
         for (int i = 0; i < 3; i++) {
             if (leaf_value == tree->escape_codes[i]) {
-                tree->escape_nodes[i] = node;
+                tree->escape_nodes[i] = index;
             }
         }
     }
-    return node;
+    return index;
 }
 
 static hufftree16 *create_tree16(bitstream *bs, hufftree8 *low, hufftree8 *high)
@@ -309,6 +372,8 @@ static hufftree16 *create_tree16(bitstream *bs, hufftree8 *low, hufftree8 *high)
     hufftree16 *tree = (hufftree16 *) clear_malloc(sizeof(hufftree16));
     if (!tree) {
         log_error("SMK: no memory for 16-bit tree", 0, 0);
+        free_tree8(low);
+        free_tree8(high);
         return NULL;
     }
     tree->low = low;
@@ -317,10 +382,10 @@ static hufftree16 *create_tree16(bitstream *bs, hufftree8 *low, hufftree8 *high)
         // Do not join the following two lines as it results in an optimization bug for MSVC. See PR #215
         tree->escape_codes[i] = read_byte(bs);
         tree->escape_codes[i] |= read_byte(bs) << 8;
+        tree->escape_nodes[i] = -1;
     }
-    tree->root = build_tree16_nodes(bs, tree);
-    if (!tree->root) {
-        free(tree);
+    if (build_tree16_nodes(bs, tree) < 0) {
+        free_tree16(tree);
         return NULL;
     }
     if (read_bit(bs) != 0) {
@@ -329,13 +394,22 @@ static hufftree16 *create_tree16(bitstream *bs, hufftree8 *low, hufftree8 *high)
         return NULL;
     }
     for (int i = 0; i < 3; i++) {
-        if (!tree->escape_nodes[i]) {
+        if (tree->escape_nodes[i] < 0) {
             // Escape node is not in the tree: create a dummy node
-            tree->escape_nodes[i] = (huffnode16 *) clear_malloc(sizeof(huffnode16));
-            tree->escape_nodes[i]->is_leaf = 0;
-            tree->escape_nodes[i]->value = 0;
+            tree->escape_nodes[i] = add_node16(tree);
+            if (tree->escape_nodes[i] < 0) {
+                free_tree16(tree);
+                return NULL;
+            }
         }
     }
+    tree->table = (uint32_t *) malloc(sizeof(uint32_t) << TREE16_TABLE_BITS);
+    if (!tree->table) {
+        log_error("SMK: no memory for 16-bit tree", 0, 0);
+        free_tree16(tree);
+        return NULL;
+    }
+    fill_table(tree->nodes, 0, 0, 0, tree->table, TREE16_TABLE_BITS);
     return tree;
 }
 
@@ -343,26 +417,23 @@ static void reset_escape16(hufftree16 *tree)
 {
     if (tree) {
         for (int i = 0; i < 3; i++) {
-            tree->escape_nodes[i]->value = 0;
+            tree->nodes[tree->escape_nodes[i]].value = 0;
         }
     }
 }
 
-static uint16_t lookup_tree16(bitstream *bs, hufftree16 *tree)
+static inline uint16_t lookup_tree16(bitstream *bs, hufftree16 *tree)
 {
     if (!tree) {
         return 0;
     }
-    huffnode16 *node = tree->root;
-    while (!node->is_leaf) {
-        node = node->b[read_bit(bs)];
-    }
-
-    uint16_t value = node->value;
-    if (value != tree->escape_nodes[0]->value) {
-        tree->escape_nodes[2]->value = tree->escape_nodes[1]->value;
-        tree->escape_nodes[1]->value = tree->escape_nodes[0]->value;
-        tree->escape_nodes[0]->value = value;
+    huffnode *nodes = tree->nodes;
+    uint16_t value = nodes[lookup_node(bs, nodes, tree->table, TREE16_TABLE_BITS)].value;
+    int32_t *escape = tree->escape_nodes;
+    if (value != nodes[escape[0]].value) {
+        nodes[escape[2]].value = nodes[escape[1]].value;
+        nodes[escape[1]].value = nodes[escape[0]].value;
+        nodes[escape[0]].value = value;
     }
     return value;
 }
@@ -467,6 +538,9 @@ static int read_frame_info(smacker s)
         s->frame_sizes[i] = read_i32(&data[4 * i]) & 0xfffffffc;
         s->frame_offsets[i] = offset;
         offset += s->frame_sizes[i];
+        if (s->frame_sizes[i] > s->max_frame_size) {
+            s->max_frame_size = s->frame_sizes[i];
+        }
     }
     return 1;
 }
@@ -490,6 +564,12 @@ static int read_trees_data(smacker s)
 
 int allocate_frame_memory(smacker s)
 {
+    // Frames are read one at a time into a single buffer that fits the largest one
+    s->frame_buffer = clear_malloc(s->max_frame_size);
+    if (!s->frame_buffer) {
+        log_error("SMK: no memory for frame data", 0, 0);
+        return 0;
+    }
     s->frame_data.video = clear_malloc(sizeof(uint8_t) * s->width * s->height);
     if (!s->frame_data.video) {
         log_error("SMK: no memory for video frame", 0, 0);
@@ -551,6 +631,7 @@ void smacker_close(smacker s)
         free(s->frame_data.audio[i]);
     }
     free(s->frame_data.video);
+    free(s->frame_buffer);
     free(s);
 }
 
@@ -702,6 +783,9 @@ static int decode_audio_track(smacker s, int track, uint8_t *data, int length)
         }
         s->frame_data.audio_len[track] = index;
     }
+    for (int i = 0; i < num_trees; i++) {
+        free_tree8(trees[i]);
+    }
     return 1;
 }
 
@@ -811,22 +895,11 @@ static uint8_t *read_frame_data(smacker s, int frame_id)
         return NULL;
     }
     int frame_size = s->frame_sizes[frame_id];
-    uint8_t *frame_data = (uint8_t *) clear_malloc(frame_size);
-    if (!frame_data) {
-        log_error("SMK: no memory for frame data", 0, frame_id);
-        return NULL;
-    }
-    if (fread(frame_data, 1, frame_size, s->fp) != frame_size) {
+    if (fread(s->frame_buffer, 1, frame_size, s->fp) != frame_size) {
         log_error("SMK: unable to read data for frame", 0, frame_id);
-        free(frame_data);
         return NULL;
     }
-    return frame_data;
-}
-
-static void free_frame_data(const smacker s, uint8_t *frame_data)
-{
-    free(frame_data);
+    return s->frame_buffer;
 }
 
 static smacker_frame_status decode_frame(smacker s)
@@ -846,7 +919,6 @@ static smacker_frame_status decode_frame(smacker s)
     if (frame_type & 0x01) {
         int palette_size = frame_data[0] * 4;
         if (!decode_palette(s, &frame_data[1], palette_size - 1)) {
-            free_frame_data(s, frame_data);
             return SMACKER_FRAME_ERROR;
         }
         data_index += palette_size;
@@ -861,11 +933,8 @@ static smacker_frame_status decode_frame(smacker s)
         }
     }
     if (!decode_video(s, &frame_data[data_index], s->frame_sizes[frame_id] - data_index)) {
-        free_frame_data(s, frame_data);
         return SMACKER_FRAME_ERROR;
     }
-
-    free_frame_data(s, frame_data);
     return SMACKER_FRAME_OK;
 }
 
@@ -16,6 +16,11 @@ enum {
     PK_EOF = 773,
 };
 
+#define PK_FAST_HASH_BITS 13
+#define PK_FAST_HASH_SIZE (1 << PK_FAST_HASH_BITS)
+#define PK_FAST_MAX_CHAIN 16
+#define PK_FAST_GOOD_LENGTH 64
+
 struct pk_token {
     int stop;
 
@@ -51,23 +56,26 @@ struct pk_comp_buffer {
 
     uint16_t codeword_values[774];
     uint8_t codeword_bits[774];
+
+    // hash chains used by ZIP_COMPRESS_FAST instead of the analyze tables
+    int fast;
+    int fast_data_start;
+    int fast_next_insert;
+    int16_t fast_head[PK_FAST_HASH_SIZE];
+    int16_t fast_prev[8708];
 };
 
 struct pk_decomp_buffer {
-    pk_input_func *input_func;
-    pk_output_func *output_func;
-    struct pk_token *token;
+    const uint8_t *input_data;
+    int input_ptr;
+    int input_length;
 
-    int window_size;
-    int dictionary_size;
-    uint16_t current_input_byte;
-    int current_input_bits_available;
+    uint64_t bit_buffer;
+    int bits_in_buffer;
+    int bits_left; // bits that may be consumed before running out of input
 
-    int input_buffer_ptr;
-    int input_buffer_end;
-    int output_buffer_ptr;
-    uint8_t input_buffer[2048];
-    uint8_t output_buffer[8708]; // 2x 4096 (max dict size) + 516 for copying
+    int window_size;
+    int copy_offset_extra_mask;
 
     uint8_t copy_offset_jump_table[256];
     uint8_t copy_length_jump_table[256];
@@ -341,10 +349,102 @@ static void pk_implode_determine_copy(struct pk_comp_buffer *buf, int input_inde
     // never reached
 }
 
+static int pk_implode_fast_hash(const uint8_t *data)
+{
+    uint32_t value = (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16);
+    return (int) ((value * 2654435761u) >> (32 - PK_FAST_HASH_BITS));
+}
+
+static void pk_implode_fast_reset(struct pk_comp_buffer *buf, int input_index)
+{
+    for (int i = 0; i < PK_FAST_HASH_SIZE; i++) {
+        buf->fast_head[i] = -1;
+    }
+    int start = input_index - buf->dictionary_size;
+    buf->fast_next_insert = start > buf->fast_data_start ? start : buf->fast_data_start;
+}
+
+static void pk_implode_fast_insert_until(struct pk_comp_buffer *buf, int input_index)
+{
+    while (buf->fast_next_insert < input_index) {
+        int index = buf->fast_next_insert++;
+        if (index + 3 > (int) sizeof(buf->input_data)) {
+            continue;
+        }
+        int hash_value = pk_implode_fast_hash(&buf->input_data[index]);
+        buf->fast_prev[index] = buf->fast_head[hash_value];
+        buf->fast_head[hash_value] = (int16_t) index;
+    }
+}
+
+static int pk_implode_match_length(const uint8_t *a, const uint8_t *b, int max_length)
+{
+    int length = 0;
+    while (length + 4 <= max_length) {
+        uint32_t word_a, word_b;
+        memcpy(&word_a, a + length, 4);
+        memcpy(&word_b, b + length, 4);
+        if (word_a != word_b) {
+            break;
+        }
+        length += 4;
+    }
+    while (length < max_length && a[length] == b[length]) {
+        length++;
+    }
+    return length;
+}
+
+/**
+ * Fast match finder: walks at most PK_FAST_MAX_CHAIN candidates of a 3-byte hash chain,
+ * newest first. Only finds copies of 3 bytes or longer.
+ */
+static void pk_implode_fast_determine_copy(struct pk_comp_buffer *buf, int input_index, struct pk_copy_length_offset *copy)
+{
+    copy->length = 0;
+    pk_implode_fast_insert_until(buf, input_index);
+
+    int max_length = (int) sizeof(buf->input_data) - input_index;
+    if (max_length < 3) {
+        return;
+    }
+    if (max_length > 516) {
+        max_length = 516;
+    }
+    const uint8_t *input_ptr = &buf->input_data[input_index];
+    int min_match_index = input_index - buf->dictionary_size;
+    int best_length = 2;
+    int candidate = buf->fast_head[pk_implode_fast_hash(input_ptr)];
+    for (int chain = 0; chain < PK_FAST_MAX_CHAIN && candidate >= min_match_index; chain++) {
+        const uint8_t *match_ptr = &buf->input_data[candidate];
+        if (match_ptr[best_length] == input_ptr[best_length]) {
+            int length = pk_implode_match_length(match_ptr, input_ptr, max_length);
+            if (length > best_length) {
+                best_length = length;
+                copy->length = length;
+                copy->offset = (uint16_t) (input_index - candidate - 1);
+                if (length >= PK_FAST_GOOD_LENGTH || length == max_length) {
+                    break;
+                }
+            }
+        }
+        candidate = buf->fast_prev[candidate];
+    }
+}
+
+static void pk_implode_find_copy(struct pk_comp_buffer *buf, int input_index, struct pk_copy_length_offset *copy)
+{
+    if (buf->fast) {
+        pk_implode_fast_determine_copy(buf, input_index, copy);
+    } else {
+        pk_implode_determine_copy(buf, input_index, copy);
+    }
+}
+
 static int pk_implode_next_copy_is_better(struct pk_comp_buffer *buf, int offset, const struct pk_copy_length_offset *current_copy)
 {
     struct pk_copy_length_offset next_copy;
-    pk_implode_determine_copy(buf, offset + 1, &next_copy);
+    pk_implode_find_copy(buf, offset + 1, &next_copy);
     if (current_copy->length >= next_copy.length) {
         return 0;
     }
@@ -384,6 +484,7 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
     buf->output_ptr = 2;
 
     int input_ptr = buf->dictionary_size + 516;
+    buf->fast_data_start = input_ptr;
     pk_memset(&buf->output_data[2], 0, 2048);
 
     buf->current_output_bits_used = 0;
@@ -401,7 +502,9 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
             input_end += 516; // eat the 516 leftovers anyway
         }
 
-        if (has_leftover_data == 0) {
+        if (buf->fast) {
+            pk_implode_fast_reset(buf, input_ptr);
+        } else if (has_leftover_data == 0) {
             pk_implode_analyze_input(buf, input_ptr, input_end + 1);
             has_leftover_data++;
             if (buf->dictionary_size != 4096) {
@@ -418,7 +521,7 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
             int write_literal = 0;
             int write_copy = 0;
             struct pk_copy_length_offset copy;
-            pk_implode_determine_copy(buf, input_ptr, &copy);
+            pk_implode_find_copy(buf, input_ptr, &copy);
 
             if (copy.length == 0) {
                 write_literal = 1;
@@ -453,6 +556,7 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
         if (!eof) {
             input_ptr -= 4096;
             pk_memcpy(buf->input_data, &buf->input_data[4096], buf->dictionary_size + 516);
+            buf->fast_data_start = buf->fast_data_start > 4096 ? buf->fast_data_start - 4096 : 0;
         }
     }
 
@@ -519,161 +623,138 @@ static void pk_explode_construct_jump_table(int size, const uint8_t *bits, const
     }
 }
 
-static int pk_explode_set_bits_used(struct pk_decomp_buffer *buf, int num_bits)
+static void pk_explode_fill_bit_buffer(struct pk_decomp_buffer *buf)
 {
-    if (buf->current_input_bits_available >= num_bits) {
-        buf->current_input_bits_available -= num_bits;
-        buf->current_input_byte = (uint16_t) (buf->current_input_byte >> num_bits);
-        return 0;
-    }
-    buf->current_input_byte = (uint16_t) (buf->current_input_byte >> buf->current_input_bits_available);
-    if (buf->input_buffer_ptr == buf->input_buffer_end) {
-        // Fill buffer
-        buf->input_buffer_ptr = 2048;
-        buf->input_buffer_end = buf->input_func(buf->input_buffer, buf->input_buffer_ptr, buf->token);
-        if (!buf->input_buffer_end) {
-            return 1;
-        }
-        buf->input_buffer_ptr = 0;
+    while (buf->bits_in_buffer <= 56 && buf->input_ptr < buf->input_length) {
+        buf->bit_buffer |= (uint64_t) buf->input_data[buf->input_ptr++] << buf->bits_in_buffer;
+        buf->bits_in_buffer += 8;
     }
+}
 
-    buf->current_input_byte |= (uint16_t) (buf->input_buffer[buf->input_buffer_ptr++] << 8);
-    buf->current_input_byte = (uint16_t) (buf->current_input_byte >> (num_bits - buf->current_input_bits_available));
-    buf->current_input_bits_available += 8 - num_bits;
+static int pk_explode_consume_bits(struct pk_decomp_buffer *buf, int num_bits)
+{
+    if (num_bits > buf->bits_left) {
+        return 1;
+    }
+    buf->bits_left -= num_bits;
+    buf->bits_in_buffer -= num_bits;
+    buf->bit_buffer >>= num_bits;
     return 0;
 }
 
-static int pk_explode_decode_next_token(struct pk_decomp_buffer *buf)
+static int pk_explode_data(struct pk_decomp_buffer *buf, uint8_t *output, int output_length, int *output_ptr)
 {
-    if (buf->current_input_byte & 1) {
-        // copy
-        if (pk_explode_set_bits_used(buf, 1)) {
-            return PK_ERROR_VALUE;
+    int out = 0;
+    int result = PK_ERROR_DECODING;
+    while (1) {
+        // a token is at most 30 bits, so one refill is enough
+        pk_explode_fill_bit_buffer(buf);
+        uint32_t bits = (uint32_t) buf->bit_buffer;
+        if (!(bits & 1)) {
+            // literal byte
+            if (pk_explode_consume_bits(buf, 9)) {
+                break;
+            }
+            if (out >= output_length) {
+                log_error("COMP2 Out of buffer space.", 0, 0);
+                break;
+            }
+            output[out++] = (uint8_t) (bits >> 1);
+            continue;
         }
-        int index = buf->copy_length_jump_table[buf->current_input_byte & 0xff];
-        if (pk_explode_set_bits_used(buf, pk_copy_length_base_bits[index])) {
-            return PK_ERROR_VALUE;
+        int index = buf->copy_length_jump_table[(bits >> 1) & 0xff];
+        int bits_used = 1 + pk_copy_length_base_bits[index];
+        if (pk_explode_consume_bits(buf, bits_used)) {
+            break;
         }
         int extra_bits = pk_copy_length_extra_bits[index];
         if (extra_bits) {
-            int extra_bits_value = buf->current_input_byte & ((1 << extra_bits) - 1);
-            if (pk_explode_set_bits_used(buf, extra_bits) && index + extra_bits_value != 270) {
-                return PK_ERROR_VALUE;
+            int extra_bits_value = (bits >> bits_used) & ((1 << extra_bits) - 1);
+            if (pk_explode_consume_bits(buf, extra_bits) && index + extra_bits_value != 270) {
+                break;
             }
             index = pk_copy_length_base_value[index] + extra_bits_value;
         }
-        return index + 256;
-    } else {
-        // literal token
-        if (pk_explode_set_bits_used(buf, 1)) {
-            return PK_ERROR_VALUE;
-        }
-        int result = buf->current_input_byte & 0xff;
-        if (pk_explode_set_bits_used(buf, 8)) {
-            return PK_ERROR_VALUE;
+        if (index + 256 == PK_EOF) {
+            result = PK_SUCCESS;
+            break;
         }
-        return result;
-    }
-}
-
-static int pk_explode_get_copy_offset(struct pk_decomp_buffer *buf, int copy_length)
-{
-    int index = buf->copy_offset_jump_table[buf->current_input_byte & 0xff];
-    if (pk_explode_set_bits_used(buf, pk_copy_offset_bits[index])) {
-        return 0;
-    }
-    int offset;
-    if (copy_length == 2) {
-        offset = (buf->current_input_byte & 3) | (index << 2);
-        if (pk_explode_set_bits_used(buf, 2)) {
-            return 0;
+        int length = index + 2;
+
+        // copy offset
+        bits = (uint32_t) buf->bit_buffer;
+        index = buf->copy_offset_jump_table[bits & 0xff];
+        bits_used = pk_copy_offset_bits[index];
+        int offset;
+        if (length == 2) {
+            offset = ((bits >> bits_used) & 3) | (index << 2);
+            bits_used += 2;
+        } else {
+            offset = ((bits >> bits_used) & buf->copy_offset_extra_mask) | (index << buf->window_size);
+            bits_used += buf->window_size;
         }
-    } else {
-        offset = (buf->current_input_byte & buf->dictionary_size) | (index << buf->window_size);
-        if (pk_explode_set_bits_used(buf, buf->window_size)) {
-            return 0;
+        if (pk_explode_consume_bits(buf, bits_used)) {
+            break;
         }
-    }
-    return offset + 1;
-}
-
-static int pk_explode_data(struct pk_decomp_buffer *buf)
-{
-    int token;
-    buf->output_buffer_ptr = 4096;
-    while (1) {
-        token = pk_explode_decode_next_token(buf);
-        if (token >= PK_ERROR_VALUE - 1) {
+        offset++;
+        if (length > output_length - out) {
+            log_error("COMP2 Out of buffer space.", 0, 0);
             break;
         }
-        if (token >= 256) {
-            // copy offset
-            int length = token - 254;
-            int offset = pk_explode_get_copy_offset(buf, length);
-            if (!offset) {
-                token = PK_ERROR_VALUE;
-                break;
+        uint8_t *dst = &output[out];
+        out += length;
+        if (offset > dst - output) {
+            // references data before the start: the dictionary starts out zeroed
+            int zeros = (int) (offset - (dst - output));
+            if (zeros > length) {
+                zeros = length;
             }
-            uint8_t *src = &buf->output_buffer[buf->output_buffer_ptr - offset];
-            uint8_t *dst = &buf->output_buffer[buf->output_buffer_ptr];
-            buf->output_buffer_ptr += length;
-            do {
-                *dst = *src;
-                src++;
-                dst++;
-            } while (--length > 0);
-        } else {
-            // literal byte
-            buf->output_buffer[buf->output_buffer_ptr++] = (uint8_t) token;
+            memset(dst, 0, (size_t) zeros);
+            dst += zeros;
+            length -= zeros;
         }
-        if (buf->output_buffer_ptr >= 8192) {
-            // Flush buffer
-            buf->output_func(&buf->output_buffer[4096], 4096, buf->token);
-            pk_memcpy(buf->output_buffer, &buf->output_buffer[4096], buf->output_buffer_ptr - 4096);
-            buf->output_buffer_ptr -= 4096;
+        const uint8_t *src = dst - offset;
+        if (offset >= length) {
+            memcpy(dst, src, (size_t) length);
+        } else {
+            // overlapping copy repeats the last offset bytes
+            for (int i = 0; i < length; i++) {
+                dst[i] = src[i];
+            }
         }
     }
-    // Flush buffer
-    buf->output_func(&buf->output_buffer[4096], buf->output_buffer_ptr - 4096, buf->token);
-    return token;
+    *output_ptr = out;
+    return result;
 }
 
-static int pk_explode(pk_input_func *input_func, pk_output_func *output_func,
-                      struct pk_decomp_buffer *buf, struct pk_token *token)
+static int pk_explode(struct pk_decomp_buffer *buf, const uint8_t *input, int input_length,
+                      uint8_t *output, int output_length, int *output_ptr)
 {
-    buf->input_func = input_func;
-    buf->output_func = output_func;
-    buf->token = token;
-    buf->input_buffer_ptr = 2048;
-    int bytes_read = buf->input_func(buf->input_buffer, buf->input_buffer_ptr, buf->token);
-    buf->input_buffer_end = bytes_read;
-    if (bytes_read <= 4) {
+    if (input_length <= 4) {
         return PK_TOO_FEW_INPUT_BYTES;
     }
-    int has_literal_encoding = buf->input_buffer[0];
-    buf->window_size = buf->input_buffer[1];
-    buf->current_input_byte = buf->input_buffer[2];
-    buf->current_input_bits_available = 0;
-    buf->input_buffer_ptr = 3;
-
+    int has_literal_encoding = input[0];
+    buf->window_size = input[1];
     if (buf->window_size < 4 || buf->window_size > 6) {
         return PK_INVALID_WINDOWSIZE;
     }
-
-    buf->dictionary_size = 0xFFFF >> (16 - buf->window_size);
+    buf->copy_offset_extra_mask = 0xFFFF >> (16 - buf->window_size);
     if (has_literal_encoding) {
         return PK_LITERAL_ENCODING_UNSUPPORTED;
     }
+    buf->input_data = input;
+    buf->input_ptr = 2;
+    buf->input_length = input_length;
+    buf->bit_buffer = 0;
+    buf->bits_in_buffer = 0;
+    // the original decoder always keeps a full byte of lookahead
+    buf->bits_left = 8 * (input_length - 2) - 8;
 
     // Decode data for copying bytes
     pk_explode_construct_jump_table(16, pk_copy_length_base_bits, pk_copy_length_base_code, buf->copy_length_jump_table);
     pk_explode_construct_jump_table(64, pk_copy_offset_bits, pk_copy_offset_code, buf->copy_offset_jump_table);
 
-    int result = pk_explode_data(buf);
-    if (result != PK_EOF) {
-        return PK_ERROR_DECODING;
-    }
-    return PK_SUCCESS;
+    return pk_explode_data(buf, output, output_length, output_ptr);
 }
 
 static int zip_input_func(uint8_t *buffer, int length, struct pk_token *token)
@@ -714,7 +795,7 @@ static void zip_output_func(uint8_t *buffer, int length, struct pk_token *token)
 }
 
 int zip_compress(const void *input_buffer, int input_length,
-                 void *output_buffer, int *output_length)
+                 void *output_buffer, int *output_length, zip_compress_level level)
 {
     struct pk_token token;
     struct pk_comp_buffer *buf = (struct pk_comp_buffer *) malloc(sizeof(struct pk_comp_buffer));
@@ -729,6 +810,7 @@ int zip_compress(const void *input_buffer, int input_length,
     token.input_length = input_length;
     token.output_data = (uint8_t *) output_buffer;
     token.output_length = *output_length;
+    buf->fast = level == ZIP_COMPRESS_FAST;
 
     int ok = 1;
     int pk_error = pk_implode(zip_input_func, zip_output_func, buf, &token, 4096);
@@ -745,26 +827,14 @@ int zip_compress(const void *input_buffer, int input_length,
 int zip_decompress(const void *input_buffer, int input_length,
                    void *output_buffer, int *output_length)
 {
-    struct pk_token token;
-    struct pk_decomp_buffer *buf = (struct pk_decomp_buffer *) malloc(sizeof(struct pk_decomp_buffer));
-    if (!buf) {
-        return 0;
-    }
-    memset(buf, 0, sizeof(struct pk_decomp_buffer));
-    memset(&token, 0, sizeof(struct pk_token));
-    token.input_data = (const uint8_t *) input_buffer;
-    token.input_length = input_length;
-    token.output_data = (uint8_t *) output_buffer;
-    token.output_length = *output_length;
-
-    int ok = 1;
-    int pk_error = pk_explode(zip_input_func, zip_output_func, buf, &token);
-    if (pk_error || token.stop) {
+    struct pk_decomp_buffer buf;
+    int written = 0;
+    int pk_error = pk_explode(&buf, (const uint8_t *) input_buffer, input_length,
+                              (uint8_t *) output_buffer, *output_length, &written);
+    if (pk_error) {
         log_error("COMP Error uncompressing.", 0, 0);
-        ok = 0;
-    } else {
-        *output_length = token.output_ptr;
+        return 0;
     }
-    free(buf);
-    return ok;
+    *output_length = written;
+    return 1;
 }
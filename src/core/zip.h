@@ -6,15 +6,25 @@
  * Compression functions.
  */
 
+/**
+ * Compression level, both produce standard PKWare DCL imploded data
+ */
+typedef enum {
+    ZIP_COMPRESS_BEST = 0, /**< Exhaustive match search, identical to the original game */
+    ZIP_COMPRESS_FAST = 1 /**< Bounded hash chain search, several times faster but slightly larger */
+} zip_compress_level;
+
 /**
  * Compresses the input buffer.
  * @param input_buffer Input buffer to compress
  * @param input_length Length of input buffer
  * @param output_buffer Output buffer to write the compressed data to
  * @param output_length IN: available length of the output buffer, OUT: written bytes
+ * @param level Compression level
  * @return boolean true on success, false on error
  */
-int zip_compress(const void *input_buffer, int input_length, void *output_buffer, int *output_length);
+int zip_compress(const void *input_buffer, int input_length, void *output_buffer, int *output_length,
+                 zip_compress_level level);
 
 /**
  * Decompresses the input buffer
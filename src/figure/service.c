@@ -12,19 +12,13 @@
 static int provide_culture(int x, int y, void (*callback)(building *))
 {
     int serviced = 0;
-    int x_min, y_min, x_max, y_max;
-    map_grid_get_area(x, y, 1, 2, &x_min, &y_min, &x_max, &y_max);
-    for (int yy = y_min; yy <= y_max; yy++) {
-        for (int xx = x_min; xx <= x_max; xx++) {
-            int grid_offset = map_grid_offset(xx, yy);
-            int building_id = map_building_at(grid_offset);
-            if (building_id) {
-                building *b = building_get(building_id);
-                if (b->house_size && b->house_population > 0) {
-                    callback(b);
-                    serviced++;
-                }
-            }
+    int building_ids[MAP_BUILDING_MAX_NEARBY];
+    int num_buildings = map_building_list_nearby(x, y, building_ids);
+    for (int i = 0; i < num_buildings; i++) {
+        building *b = building_get(building_ids[i]);
+        if (b->house_size && b->house_population > 0) {
+            callback(b);
+            serviced++;
         }
     }
     return serviced;
@@ -33,19 +27,13 @@ static int provide_culture(int x, int y, void (*callback)(building *))
 static int provide_entertainment(int x, int y, int shows, void (*callback)(building *, int))
 {
     int serviced = 0;
-    int x_min, y_min, x_max, y_max;
-    map_grid_get_area(x, y, 1, 2, &x_min, &y_min, &x_max, &y_max);
-    for (int yy = y_min; yy <= y_max; yy++) {
-        for (int xx = x_min; xx <= x_max; xx++) {
-            int grid_offset = map_grid_offset(xx, yy);
-            int building_id = map_building_at(grid_offset);
-            if (building_id) {
-                building *b = building_get(building_id);
-                if (b->house_size && b->house_population > 0) {
-                    callback(b, shows);
-                    serviced++;
-                }
-            }
+    int building_ids[MAP_BUILDING_MAX_NEARBY];
+    int num_buildings = map_building_list_nearby(x, y, building_ids);
+    for (int i = 0; i < num_buildings; i++) {
+        building *b = building_get(building_ids[i]);
+        if (b->house_size && b->house_population > 0) {
+            callback(b, shows);
+            serviced++;
         }
     }
     return serviced;
@@ -162,19 +150,13 @@ static int provide_missionary_coverage(int x, int y)
 static int provide_service(int x, int y, int *data, void (*callback)(building *, int *))
 {
     int serviced = 0;
-    int x_min, y_min, x_max, y_max;
-    map_grid_get_area(x, y, 1, 2, &x_min, &y_min, &x_max, &y_max);
-    for (int yy = y_min; yy <= y_max; yy++) {
-        for (int xx = x_min; xx <= x_max; xx++) {
-            int grid_offset = map_grid_offset(xx, yy);
-            int building_id = map_building_at(grid_offset);
-            if (building_id) {
-                building *b = building_get(building_id);
-                callback(b, data);
-                if (b->house_size && b->house_population > 0) {
-                    serviced++;
-                }
-            }
+    int building_ids[MAP_BUILDING_MAX_NEARBY];
+    int num_buildings = map_building_list_nearby(x, y, building_ids);
+    for (int i = 0; i < num_buildings; i++) {
+        building *b = building_get(building_ids[i]);
+        callback(b, data);
+        if (b->house_size && b->house_population > 0) {
+            serviced++;
         }
     }
     return serviced;
@@ -279,19 +261,13 @@ static int provide_market_goods(int market_building_id, int x, int y)
 {
     int serviced = 0;
     building *market = building_get(market_building_id);
-    int x_min, y_min, x_max, y_max;
-    map_grid_get_area(x, y, 1, 2, &x_min, &y_min, &x_max, &y_max);
-    for (int yy = y_min; yy <= y_max; yy++) {
-        for (int xx = x_min; xx <= x_max; xx++) {
-            int grid_offset = map_grid_offset(xx, yy);
-            int building_id = map_building_at(grid_offset);
-            if (building_id) {
-                building *b = building_get(building_id);
-                if (b->house_size && b->house_population > 0) {
-                    distribute_market_resources(b, market);
-                    serviced++;
-                }
-            }
+    int building_ids[MAP_BUILDING_MAX_NEARBY];
+    int num_buildings = map_building_list_nearby(x, y, building_ids);
+    for (int i = 0; i < num_buildings; i++) {
+        building *b = building_get(building_ids[i]);
+        if (b->house_size && b->house_population > 0) {
+            distribute_market_resources(b, market);
+            serviced++;
         }
     }
     return serviced;
@@ -17,6 +17,7 @@
 #include "core/file.h"
 #include "core/image.h"
 #include "core/io.h"
+#include "core/log.h"
 #include "core/string.h"
 #include "empire/empire.h"
 #include "empire/trade_prices.h"
@@ -30,8 +31,10 @@
 #include "game/animation.h"
 #include "game/difficulty.h"
 #include "game/file_io.h"
+#include "game/replay.h"
 #include "game/settings.h"
 #include "game/state.h"
+#include "game/system.h"
 #include "game/time.h"
 #include "game/tutorial.h"
 #include "game/undo.h"
@@ -206,15 +209,41 @@ static void load_empire_data(int is_custom_scenario, int empire_id)
     scenario_distant_battle_set_enemy_travel_months();
 }
 
+static struct {
+    unsigned int start;
+    unsigned int stage_start;
+} load_timer;
+
+static void start_load_timer(void)
+{
+    load_timer.start = system_get_ticks();
+    load_timer.stage_start = load_timer.start;
+}
+
+static void log_load_stage(const char *stage)
+{
+    unsigned int now = system_get_ticks();
+    log_info("Load stage finished, ms:", stage, (int) (now - load_timer.stage_start));
+    load_timer.stage_start = now;
+}
+
+static void log_load_total(void)
+{
+    log_info("Game loaded, total ms:", 0, (int) (system_get_ticks() - load_timer.start));
+}
+
 static void initialize_saved_game(void)
 {
     load_empire_data(scenario_is_custom(), scenario_empire_id());
+    log_load_stage("empire");
 
     scenario_map_init();
 
     city_view_init();
+    log_load_stage("map");
 
     map_routing_update_all();
+    log_load_stage("routing");
 
     map_orientation_update_buildings();
     figure_route_clean();
@@ -223,6 +252,7 @@ static void initialize_saved_game(void)
     building_granaries_calculate_stocks();
     building_menu_update();
     city_message_init_problem_areas();
+    log_load_stage("buildings");
 
     sound_city_init();
 
@@ -234,6 +264,8 @@ static void initialize_saved_game(void)
 
     image_load_climate(scenario_property_climate(), 0, 0);
     image_load_enemy(scenario_property_enemy());
+    log_load_stage("graphics");
+
     city_military_determine_distant_battle_city();
     map_tiles_determine_gardens();
 
@@ -259,9 +291,11 @@ static int load_campaign_mission(int mission_id)
     if (offset <= 0) {
         return 0;
     }
+    start_load_timer();
     if (!game_file_io_read_saved_game(MISSION_PACK_FILE, offset)) {
         return 0;
     }
+    log_load_stage("mission file");
 
     if (mission_id == 0) {
         scenario_set_player_name(setting_player_name());
@@ -270,6 +304,7 @@ static int load_campaign_mission(int mission_id)
     }
     initialize_saved_game();
     city_data_init_campaign_mission();
+    log_load_total();
     return 1;
 }
 
@@ -277,6 +312,7 @@ static int start_scenario(const uint8_t *scenario_name, const char *scenario_fil
 {
     int mission = scenario_campaign_mission();
     int rank = scenario_campaign_rank();
+    game_replay_stop_recording();
     map_bookmarks_clear();
     if (scenario_is_custom()) {
         if (!load_custom_scenario(scenario_name, scenario_file)) {
@@ -346,13 +382,38 @@ int game_file_load_scenario_data(const char *scenario_file)
 
 int game_file_load_saved_game(const char *filename)
 {
+    start_load_timer();
     if (!game_file_io_read_saved_game(filename, 0)) {
         return 0;
     }
+    log_load_stage("saved game file");
     initialize_saved_game();
     building_storage_reset_building_ids();
 
     sound_music_update(1);
+    log_load_total();
+    game_replay_start_recording(filename);
+    return 1;
+}
+
+int game_file_write_snapshot(void)
+{
+    return game_file_io_write_snapshot();
+}
+
+int game_file_load_snapshot(int drop_newest)
+{
+    start_load_timer();
+    if (!game_file_io_read_snapshot(drop_newest)) {
+        return 0;
+    }
+    game_replay_stop_recording();
+    log_load_stage("snapshot");
+    initialize_saved_game();
+    building_storage_reset_building_ids();
+
+    sound_music_update(1);
+    log_load_total();
     return 1;
 }
 
@@ -361,6 +422,11 @@ int game_file_write_saved_game(const char *filename)
     return game_file_io_write_saved_game(filename);
 }
 
+int game_file_write_saved_game_in_background(const char *filename)
+{
+    return game_file_io_write_saved_game_in_background(filename);
+}
+
 int game_file_delete_saved_game(const char *filename)
 {
     return game_file_io_delete_saved_game(filename);
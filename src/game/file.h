@@ -31,6 +31,19 @@ int game_file_load_scenario_data(const char *scenario_file);
  */
 int game_file_load_saved_game(const char *filename);
 
+/**
+ * Keep a snapshot of the current game in memory, for quickly returning to it
+ * @return Boolean true on success, false on failure
+ */
+int game_file_write_snapshot(void);
+
+/**
+ * Restore the game from the newest in-memory snapshot, without disk access or decompression
+ * @param drop_newest Discard the newest snapshot and restore the one taken before it
+ * @return Boolean true on success, false if there is no snapshot
+ */
+int game_file_load_snapshot(int drop_newest);
+
 /**
  * Write saved game to disk
  * @param filename File to save to
@@ -38,6 +51,13 @@ int game_file_load_saved_game(const char *filename);
  */
 int game_file_write_saved_game(const char *filename);
 
+/**
+ * Write saved game to disk on a background thread, skipped when the previous one is still being written
+ * @param filename File to save to
+ * @return Boolean true if the save was started, false if it was skipped
+ */
+int game_file_write_saved_game_in_background(const char *filename);
+
 /**
  * Delete saved game
  * @param filename File to delete
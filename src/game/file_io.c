@@ -22,6 +22,7 @@
 #include "figure/name.h"
 #include "figure/route.h"
 #include "figure/trader.h"
+#include "game/system.h"
 #include "game/time.h"
 #include "game/tutorial.h"
 #include "map/aqueduct.h"
@@ -50,10 +51,12 @@
 
 #define COMPRESS_BUFFER_SIZE 600000
 #define UNCOMPRESSED 0x80000000
+#define MAX_PIECES 100
+#define MAX_SNAPSHOTS 5
+#define MAX_COMPRESS_WORKERS 8
 
 static const int SAVE_GAME_VERSION = 0x66;
 
-static char compress_buffer[COMPRESS_BUFFER_SIZE];
 
 static int savegame_version;
 
@@ -169,10 +172,28 @@ typedef struct {
 
 static struct {
     int num_pieces;
-    file_piece pieces[100];
+    file_piece pieces[MAX_PIECES];
     savegame_state state;
 } savegame_data = {0};
 
+static struct {
+    int num_pieces;
+    file_piece pieces[MAX_PIECES];
+    char filename[FILE_NAME_MAX];
+    char temp_filename[FILE_NAME_MAX + 4];
+} background_save = {0};
+
+typedef struct {
+    int num_pieces;
+    file_piece pieces[MAX_PIECES];
+} savegame_snapshot;
+
+static struct {
+    savegame_snapshot items[MAX_SNAPSHOTS];
+    int newest;
+    int count;
+} snapshots = {0};
+
 static void init_file_piece(file_piece *piece, int size, int compressed)
 {
     piece->compressed = compressed;
@@ -563,69 +584,179 @@ static void write_int32(FILE *fp, int value)
     fwrite(&data, 1, 4, fp);
 }
 
-static int read_compressed_chunk(FILE *fp, void *buffer, int bytes_to_read)
+typedef struct {
+    file_piece *pieces;
+    int num_pieces;
+    zip_compress_level level;
+    uint8_t *file_data; // whole file when loading: data[] points into it
+    uint8_t *data[MAX_PIECES]; // compressed data of each piece, 0 = not compressed
+    int size[MAX_PIECES];
+    int ok[MAX_PIECES];
+    char *scratch[MAX_COMPRESS_WORKERS];
+} compress_job;
+
+static void compress_piece(int index, int worker, void *data)
 {
-    if (bytes_to_read > COMPRESS_BUFFER_SIZE) {
-        return 0;
+    compress_job *job = (compress_job *) data;
+    const file_piece *piece = &job->pieces[index];
+    if (!piece->compressed || piece->buf.size > COMPRESS_BUFFER_SIZE) {
+        return;
     }
-    int input_size = read_int32(fp);
-    if ((unsigned int) input_size == UNCOMPRESSED) {
-        if (fread(buffer, 1, bytes_to_read, fp) != bytes_to_read) {
-            return 0;
+    if (!job->scratch[worker]) {
+        job->scratch[worker] = (char *) malloc(COMPRESS_BUFFER_SIZE);
+        if (!job->scratch[worker]) {
+            return;
+        }
+    }
+    int output_size = COMPRESS_BUFFER_SIZE;
+    if (zip_compress(piece->buf.data, piece->buf.size, job->scratch[worker], &output_size, job->level)) {
+        job->data[index] = (uint8_t *) malloc(output_size);
+        if (job->data[index]) {
+            memcpy(job->data[index], job->scratch[worker], output_size);
+            job->size[index] = output_size;
+        }
+    }
+}
+
+static void decompress_piece(int index, int worker, void *data)
+{
+    compress_job *job = (compress_job *) data;
+    if (!job->data[index]) {
+        return;
+    }
+    file_piece *piece = &job->pieces[index];
+    int output_size = piece->buf.size;
+    job->ok[index] = zip_decompress(job->data[index], job->size[index], piece->buf.data, &output_size);
+}
+
+static void run_piece_tasks(compress_job *job, void (*task)(int index, int worker, void *data))
+{
+    if (!system_run_parallel_tasks(task, job->num_pieces, MAX_COMPRESS_WORKERS, job)) {
+        for (int i = 0; i < job->num_pieces; i++) {
+            task(i, 0, job);
         }
+    }
+}
+
+static void free_compress_job(compress_job *job)
+{
+    if (job->file_data) {
+        free(job->file_data);
     } else {
-        if (fread(compress_buffer, 1, input_size, fp) != input_size || !zip_decompress(compress_buffer, input_size, buffer, &bytes_to_read)) {
-            return 0;
+        for (int i = 0; i < job->num_pieces; i++) {
+            free(job->data[i]);
         }
     }
-    return 1;
+    for (int i = 0; i < MAX_COMPRESS_WORKERS; i++) {
+        free(job->scratch[i]);
+    }
+    free(job);
 }
 
-static int write_compressed_chunk(FILE *fp, const void *buffer, int bytes_to_write)
+static uint8_t *read_remaining_file(FILE *fp, int *size)
 {
-    if (bytes_to_write > COMPRESS_BUFFER_SIZE) {
+    long start = ftell(fp);
+    if (start < 0 || fseek(fp, 0, SEEK_END)) {
         return 0;
     }
-    int output_size = COMPRESS_BUFFER_SIZE;
-    if (zip_compress(buffer, bytes_to_write, compress_buffer, &output_size)) {
-        write_int32(fp, output_size);
-        fwrite(compress_buffer, 1, output_size, fp);
-    } else {
-        // unable to compress: write uncompressed
-        write_int32(fp, UNCOMPRESSED);
-        fwrite(buffer, 1, bytes_to_write, fp);
+    long end = ftell(fp);
+    if (end < start || fseek(fp, start, SEEK_SET)) {
+        return 0;
     }
+    uint8_t *data = (uint8_t *) malloc(end > start ? (size_t) (end - start) : 1);
+    if (!data) {
+        return 0;
+    }
+    *size = (int) fread(data, 1, (size_t) (end - start), fp);
+    return data;
+}
+
+static int read_compressed_chunk(buffer *file, compress_job *job, int index)
+{
+    file_piece *piece = &job->pieces[index];
+    int input_size = buffer_read_i32(file);
+    if ((unsigned int) input_size == UNCOMPRESSED) {
+        return buffer_read_raw(file, piece->buf.data, piece->buf.size) == piece->buf.size;
+    }
+    if (input_size <= 0 || input_size > file->size - file->index) {
+        return 0;
+    }
+    // decompressed later straight from the file data, together with the other pieces
+    job->data[index] = &file->data[file->index];
+    job->size[index] = input_size;
+    buffer_skip(file, input_size);
     return 1;
 }
 
 static int savegame_read_from_file(FILE *fp)
 {
+    compress_job *job = (compress_job *) calloc(1, sizeof(compress_job));
+    if (!job) {
+        return 0;
+    }
+    int file_size = 0;
+    job->file_data = read_remaining_file(fp, &file_size);
+    if (!job->file_data) {
+        free(job);
+        return 0;
+    }
+    buffer file;
+    buffer_init(&file, job->file_data, file_size);
+    job->pieces = savegame_data.pieces;
+    job->num_pieces = savegame_data.num_pieces;
+    int last = savegame_data.num_pieces - 1;
     for (int i = 0; i < savegame_data.num_pieces; i++) {
         file_piece *piece = &savegame_data.pieces[i];
-        int result = 0;
         if (piece->compressed) {
-            result = read_compressed_chunk(fp, piece->buf.data, piece->buf.size);
+            job->ok[i] = read_compressed_chunk(&file, job, i);
         } else {
-            result = fread(piece->buf.data, 1, piece->buf.size, fp) == piece->buf.size;
+            job->ok[i] = buffer_read_raw(&file, piece->buf.data, piece->buf.size) == piece->buf.size;
         }
         // The last piece may be smaller than buf.size
-        if (!result && i != (savegame_data.num_pieces - 1)) {
+        if (!job->ok[i] && i != last) {
+            free_compress_job(job);
             return 0;
         }
     }
-    return 1;
+    run_piece_tasks(job, decompress_piece);
+    int result = 1;
+    for (int i = 0; i < last; i++) {
+        if (!job->ok[i]) {
+            result = 0;
+            break;
+        }
+    }
+    free_compress_job(job);
+    return result;
 }
 
-static void savegame_write_to_file(FILE *fp)
+static void savegame_write_to_file(FILE *fp, file_piece *pieces, int num_pieces, zip_compress_level level)
 {
-    for (int i = 0; i < savegame_data.num_pieces; i++) {
-        file_piece *piece = &savegame_data.pieces[i];
-        if (piece->compressed) {
-            write_compressed_chunk(fp, piece->buf.data, piece->buf.size);
+    compress_job *job = (compress_job *) calloc(1, sizeof(compress_job));
+    if (!job) {
+        log_error("Out of memory while saving", 0, 0);
+        return;
+    }
+    job->pieces = pieces;
+    job->num_pieces = num_pieces;
+    job->level = level;
+    run_piece_tasks(job, compress_piece);
+    for (int i = 0; i < num_pieces; i++) {
+        file_piece *piece = &pieces[i];
+        if (!piece->compressed) {
+            fwrite(piece->buf.data, 1, piece->buf.size, fp);
+        } else if (piece->buf.size > COMPRESS_BUFFER_SIZE) {
+            continue;
+        } else if (job->data[i]) {
+            write_int32(fp, job->size[i]);
+            fwrite(job->data[i], 1, job->size[i], fp);
         } else {
+            // unable to compress: write uncompressed
+            write_int32(fp, UNCOMPRESSED);
             fwrite(piece->buf.data, 1, piece->buf.size, fp);
         }
     }
+    free_compress_job(job);
 }
 
 int game_file_io_read_saved_game(const char *filename, int offset)
@@ -664,8 +795,176 @@ int game_file_io_write_saved_game(const char *filename)
         log_error("Unable to save game", 0, 0);
         return 0;
     }
-    savegame_write_to_file(fp);
+    savegame_write_to_file(fp, savegame_data.pieces, savegame_data.num_pieces, ZIP_COMPRESS_BEST);
+    file_close(fp);
+    return 1;
+}
+
+static void write_background_save(void *unused)
+{
+    FILE *fp = file_open(background_save.temp_filename, "wb");
+    if (!fp) {
+        log_error("Unable to save game", background_save.filename, 0);
+        return;
+    }
+    // autosaves favour speed over size
+    savegame_write_to_file(fp, background_save.pieces, background_save.num_pieces, ZIP_COMPRESS_FAST);
+    file_close(fp);
+    // replace the old file only when the new one is complete
+    if (!file_rename(background_save.temp_filename, background_save.filename)) {
+        log_error("Unable to save game", background_save.filename, 0);
+    }
+}
+
+static void copy_savegame_pieces(file_piece *pieces, int *num_pieces)
+{
+    if (!*num_pieces) {
+        for (int i = 0; i < savegame_data.num_pieces; i++) {
+            init_file_piece(&pieces[i], savegame_data.pieces[i].buf.size, savegame_data.pieces[i].compressed);
+        }
+        *num_pieces = savegame_data.num_pieces;
+    }
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        memcpy(pieces[i].buf.data, savegame_data.pieces[i].buf.data, savegame_data.pieces[i].buf.size);
+    }
+}
+
+int game_file_io_write_saved_game_in_background(const char *filename)
+{
+    if (system_background_task_running(BACKGROUND_TASK_SAVE_GAME)) {
+        log_info("Previous save still in progress, skipping", filename, 0);
+        return 0;
+    }
+    init_savegame_data();
+
+    log_info("Saving game in background", filename, 0);
+    savegame_version = SAVE_GAME_VERSION;
+    savegame_save_to_state(&savegame_data.state);
+    copy_savegame_pieces(background_save.pieces, &background_save.num_pieces);
+
+    strncpy(background_save.filename, filename, FILE_NAME_MAX - 1);
+    snprintf(background_save.temp_filename, FILE_NAME_MAX + 4, "%s.tmp", background_save.filename);
+    if (!system_start_background_task(BACKGROUND_TASK_SAVE_GAME, write_background_save, 0)) {
+        write_background_save(0);
+    }
+    return 1;
+}
+
+int game_file_io_write_snapshot(void)
+{
+    init_savegame_data();
+
+    savegame_version = SAVE_GAME_VERSION;
+    savegame_save_to_state(&savegame_data.state);
+
+    snapshots.newest = (snapshots.newest + 1) % MAX_SNAPSHOTS;
+    savegame_snapshot *snapshot = &snapshots.items[snapshots.newest];
+    copy_savegame_pieces(snapshot->pieces, &snapshot->num_pieces);
+    if (snapshots.count < MAX_SNAPSHOTS) {
+        snapshots.count++;
+    }
+    return 1;
+}
+
+int game_file_io_read_snapshot(int drop_newest)
+{
+    if (drop_newest && snapshots.count > 1) {
+        snapshots.newest = (snapshots.newest + MAX_SNAPSHOTS - 1) % MAX_SNAPSHOTS;
+        snapshots.count--;
+    }
+    if (!snapshots.count) {
+        return 0;
+    }
+    init_savegame_data();
+
+    const savegame_snapshot *snapshot = &snapshots.items[snapshots.newest];
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        memcpy(savegame_data.pieces[i].buf.data, snapshot->pieces[i].buf.data, savegame_data.pieces[i].buf.size);
+    }
+    savegame_load_from_state(&savegame_data.state);
+    return 1;
+}
+
+static int is_info_piece(const buffer *buf)
+{
+    const savegame_state *state = &savegame_data.state;
+    return buf == state->city_data || buf == state->game_time || buf == state->scenario_name;
+}
+
+static int read_info_piece(FILE *fp, file_piece *piece)
+{
+    if (!piece->compressed) {
+        return fread(piece->buf.data, 1, piece->buf.size, fp) == piece->buf.size;
+    }
+    int input_size = read_int32(fp);
+    if ((unsigned int) input_size == UNCOMPRESSED) {
+        return fread(piece->buf.data, 1, piece->buf.size, fp) == piece->buf.size;
+    }
+    if (input_size <= 0) {
+        return 0;
+    }
+    uint8_t *data = (uint8_t *) malloc(input_size);
+    if (!data) {
+        return 0;
+    }
+    int output_size = piece->buf.size;
+    int ok = fread(data, 1, input_size, fp) == input_size &&
+        zip_decompress(data, input_size, piece->buf.data, &output_size);
+    free(data);
+    return ok;
+}
+
+static int skip_piece(FILE *fp, const file_piece *piece)
+{
+    int size = piece->buf.size;
+    if (piece->compressed) {
+        size = read_int32(fp);
+        if ((unsigned int) size == UNCOMPRESSED) {
+            size = piece->buf.size;
+        } else if (size <= 0) {
+            return 0;
+        }
+    }
+    return fseek(fp, size, SEEK_CUR) == 0;
+}
+
+static int savegame_read_info_from_file(FILE *fp)
+{
+    int pieces_needed = 3;
+    for (int i = 0; i < savegame_data.num_pieces && pieces_needed > 0; i++) {
+        file_piece *piece = &savegame_data.pieces[i];
+        if (is_info_piece(&piece->buf)) {
+            if (!read_info_piece(fp, piece)) {
+                return 0;
+            }
+            pieces_needed--;
+        } else if (!skip_piece(fp, piece)) {
+            return 0;
+        }
+    }
+    return pieces_needed == 0;
+}
+
+int game_file_io_read_saved_game_info(const char *filename, saved_game_info *info)
+{
+    init_savegame_data();
+
+    FILE *fp = file_open(dir_get_file(filename, NOT_LOCALIZED), "rb");
+    if (!fp) {
+        return 0;
+    }
+    int result = savegame_read_info_from_file(fp);
     file_close(fp);
+    if (!result) {
+        return 0;
+    }
+    savegame_state *state = &savegame_data.state;
+    city_data_load_basic_info(state->city_data, &info->population, &info->treasury);
+    buffer_skip(state->game_time, 8); // tick and day
+    info->month = buffer_read_i32(state->game_time);
+    info->year = buffer_read_i32(state->game_time);
+    buffer_read_raw(state->scenario_name, info->scenario_name, sizeof(info->scenario_name));
+    info->scenario_name[sizeof(info->scenario_name) - 1] = 0;
     return 1;
 }
 
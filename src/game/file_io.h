@@ -1,6 +1,19 @@
 #ifndef GAME_FILE_IO_H
 #define GAME_FILE_IO_H
 
+#include <stdint.h>
+
+/**
+ * Summary of a saved game, as shown in the file dialog
+ */
+typedef struct {
+    uint8_t scenario_name[65];
+    int month;
+    int year;
+    int population;
+    int treasury;
+} saved_game_info;
+
 int game_file_io_read_scenario(const char *filename);
 
 int game_file_io_write_scenario(const char *filename);
@@ -9,6 +22,36 @@ int game_file_io_read_saved_game(const char *filename, int offset);
 
 int game_file_io_write_saved_game(const char *filename);
 
+/**
+ * Reads the summary of a saved game, decompressing only the pieces it needs
+ * @param filename File to read
+ * @param info Summary to fill
+ * @return true if the summary was read, false on error
+ */
+int game_file_io_read_saved_game_info(const char *filename, saved_game_info *info);
+
+/**
+ * Copies the game state and writes it to disk on a background thread.
+ * Does nothing while a previous background save is still running.
+ * @param filename File to save to
+ * @return true if the save was started, false if it was skipped
+ */
+int game_file_io_write_saved_game_in_background(const char *filename);
+
+/**
+ * Keeps an uncompressed copy of the game state in memory.
+ * The last few snapshots are kept, the oldest one is dropped when full.
+ * @return true if the snapshot was taken
+ */
+int game_file_io_write_snapshot(void);
+
+/**
+ * Restores the game state from the newest snapshot
+ * @param drop_newest Discard the newest snapshot first and restore the one before it
+ * @return true if a snapshot was restored, false if there are none
+ */
+int game_file_io_read_snapshot(int drop_newest);
+
 int game_file_io_delete_saved_game(const char *filename);
 
 #endif // GAME_FILE_IO_H
@@ -220,6 +220,7 @@ void game_draw(void)
 {
     window_draw(0);
     sound_city_play();
+    sound_system_update();
 }
 
 void game_exit(void)
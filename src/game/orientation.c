@@ -3,11 +3,13 @@
 #include "city/view.h"
 #include "city/warning.h"
 #include "core/direction.h"
+#include "game/replay.h"
 #include "map/orientation.h"
 #include "widget/minimap.h"
 
 void game_orientation_rotate_left(void)
 {
+    game_replay_record_rotation(REPLAY_ROTATE_LEFT);
     city_view_rotate_left();
     map_orientation_change(0);
     widget_minimap_invalidate();
@@ -16,6 +18,7 @@ void game_orientation_rotate_left(void)
 
 void game_orientation_rotate_right(void)
 {
+    game_replay_record_rotation(REPLAY_ROTATE_RIGHT);
     city_view_rotate_right();
     map_orientation_change(1);
     widget_minimap_invalidate();
@@ -24,6 +27,7 @@ void game_orientation_rotate_right(void)
 
 void game_orientation_rotate_north(void)
 {
+    game_replay_record_rotation(REPLAY_ROTATE_NORTH);
     switch (city_view_orientation()) {
         case DIR_2_RIGHT:
             city_view_rotate_right();
@@ -0,0 +1,434 @@
+#include "replay.h"
+
+#include "building/construction.h"
+#include "building/construction_clear.h"
+#include "city/finance.h"
+#include "city/labor.h"
+#include "core/buffer.h"
+#include "core/file.h"
+#include "core/log.h"
+#include "core/random.h"
+#include "game/file.h"
+#include "game/orientation.h"
+#include "game/undo.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_VERSION 1
+#define RANDOM_STATE_SIZE 8
+#define COMMAND_TYPE_BITS 3
+#define MAX_SAVED_GAME_NAME 255
+
+static const char REPLAY_MAGIC[4] = {'J', 'R', 'P', 'L'};
+
+typedef enum {
+    COMMAND_END = 0,
+    COMMAND_CONSTRUCTION = 1,
+    COMMAND_CLEAR_LAND_CONFIRMATION = 2,
+    COMMAND_UNDO = 3,
+    COMMAND_ROTATION = 4,
+    COMMAND_TAX_CHANGE = 5,
+    COMMAND_WAGE_CHANGE = 6
+} command_type;
+
+typedef enum {
+    REPLAY_IDLE = 0,
+    REPLAY_RECORDING = 1,
+    REPLAY_PLAYING = 2
+} replay_state;
+
+static struct {
+    replay_state state;
+    char saved_game[FILE_NAME_MAX];
+    uint8_t random_state[RANDOM_STATE_SIZE];
+    int tick;
+    int last_command_tick;
+    int last_x;
+    int last_y;
+    uint8_t *log;
+    int log_size;
+    int log_capacity;
+    int read_pos;
+    int read_error;
+    int next_tick;
+    command_type next_command;
+} data;
+
+static void reset(void)
+{
+    free(data.log);
+    memset(&data, 0, sizeof(data));
+}
+
+static void save_random_state(uint8_t *state)
+{
+    buffer buf;
+    buffer_init(&buf, state, RANDOM_STATE_SIZE);
+    random_save_state(&buf);
+}
+
+static int put_u8(uint8_t value)
+{
+    if (data.log_size >= data.log_capacity) {
+        int capacity = data.log_capacity ? 2 * data.log_capacity : 1024;
+        uint8_t *log = (uint8_t *) realloc(data.log, capacity);
+        if (!log) {
+            log_error("Out of memory for the replay, recording stopped", 0, 0);
+            reset();
+            return 0;
+        }
+        data.log = log;
+        data.log_capacity = capacity;
+    }
+    data.log[data.log_size++] = value;
+    return 1;
+}
+
+static void put_varint(uint32_t value)
+{
+    while (value >= 0x80) {
+        if (!put_u8((uint8_t) (value | 0x80))) {
+            return;
+        }
+        value >>= 7;
+    }
+    put_u8((uint8_t) value);
+}
+
+static void put_signed(int value)
+{
+    // zigzag encoding keeps small negative numbers small
+    put_varint(value < 0 ? ((uint32_t) -value << 1) - 1 : (uint32_t) value << 1);
+}
+
+static void put_raw(const void *values, int size)
+{
+    const uint8_t *bytes = (const uint8_t *) values;
+    for (int i = 0; i < size; i++) {
+        put_u8(bytes[i]);
+    }
+}
+
+static uint8_t get_u8(void)
+{
+    if (data.read_pos >= data.log_size) {
+        data.read_error = 1;
+        return 0;
+    }
+    return data.log[data.read_pos++];
+}
+
+static uint32_t get_varint(void)
+{
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t byte = get_u8();
+        value |= (uint32_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    data.read_error = 1;
+    return 0;
+}
+
+static int get_signed(void)
+{
+    uint32_t value = get_varint();
+    return (value & 1) ? -(int) (value >> 1) - 1 : (int) (value >> 1);
+}
+
+static int start_command(command_type type)
+{
+    if (data.state != REPLAY_RECORDING) {
+        return 0;
+    }
+    put_varint((uint32_t) (data.tick - data.last_command_tick) << COMMAND_TYPE_BITS | type);
+    data.last_command_tick = data.tick;
+    return data.state == REPLAY_RECORDING;
+}
+
+void game_replay_start_recording(const char *saved_game)
+{
+    reset();
+    if (strlen(saved_game) > MAX_SAVED_GAME_NAME) {
+        return;
+    }
+    data.state = REPLAY_RECORDING;
+    strncpy(data.saved_game, saved_game, FILE_NAME_MAX - 1);
+    save_random_state(data.random_state);
+}
+
+void game_replay_stop_recording(void)
+{
+    if (data.state == REPLAY_RECORDING) {
+        reset();
+    }
+}
+
+void game_replay_record_unsupported_command(void)
+{
+    if (data.state == REPLAY_RECORDING) {
+        log_info("Command cannot be recorded, replay recording stopped", 0, data.tick);
+        reset();
+    }
+}
+
+void game_replay_record_construction(building_type type, building_type sub_type, int road_orientation,
+    int x_start, int y_start, int x_end, int y_end)
+{
+    if (!start_command(COMMAND_CONSTRUCTION)) {
+        return;
+    }
+    put_varint(type);
+    put_varint(sub_type);
+    put_u8((uint8_t) road_orientation);
+    put_signed(x_start - data.last_x);
+    put_signed(y_start - data.last_y);
+    put_signed(x_end - x_start);
+    put_signed(y_end - y_start);
+    data.last_x = x_end;
+    data.last_y = y_end;
+}
+
+void game_replay_record_clear_land_confirmation(int accepted)
+{
+    if (start_command(COMMAND_CLEAR_LAND_CONFIRMATION)) {
+        put_u8(accepted == 1);
+    }
+}
+
+void game_replay_record_undo(void)
+{
+    start_command(COMMAND_UNDO);
+}
+
+void game_replay_record_rotation(replay_rotation rotation)
+{
+    if (start_command(COMMAND_ROTATION)) {
+        put_u8((uint8_t) rotation);
+    }
+}
+
+void game_replay_record_tax_change(int change)
+{
+    if (start_command(COMMAND_TAX_CHANGE)) {
+        put_signed(change);
+    }
+}
+
+void game_replay_record_wage_change(int change)
+{
+    if (start_command(COMMAND_WAGE_CHANGE)) {
+        put_signed(change);
+    }
+}
+
+int game_replay_save(void)
+{
+    if (data.state != REPLAY_RECORDING) {
+        return 0;
+    }
+    char filename[FILE_NAME_MAX];
+    strncpy(filename, data.saved_game, FILE_NAME_MAX - 5);
+    filename[FILE_NAME_MAX - 5] = 0;
+    if (file_has_extension(filename, "sav")) {
+        file_change_extension(filename, "rpl");
+    } else {
+        file_append_extension(filename, "rpl");
+    }
+    FILE *fp = file_open(filename, "wb");
+    if (!fp) {
+        log_error("Unable to write replay", filename, 0);
+        return 0;
+    }
+    uint8_t header[sizeof(REPLAY_MAGIC) + 2 + MAX_SAVED_GAME_NAME + RANDOM_STATE_SIZE];
+    int name_length = (int) strlen(data.saved_game);
+    memcpy(header, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    header[4] = REPLAY_VERSION;
+    header[5] = (uint8_t) name_length;
+    memcpy(&header[6], data.saved_game, name_length);
+    memcpy(&header[6 + name_length], data.random_state, RANDOM_STATE_SIZE);
+    int header_size = 6 + name_length + RANDOM_STATE_SIZE;
+
+    // the end marker and final state are appended temporarily so recording can go on afterwards
+    int log_size = data.log_size;
+    put_varint((uint32_t) (data.tick - data.last_command_tick) << COMMAND_TYPE_BITS | COMMAND_END);
+    uint8_t random_state[RANDOM_STATE_SIZE];
+    save_random_state(random_state);
+    put_raw(random_state, RANDOM_STATE_SIZE);
+
+    int ok = data.state == REPLAY_RECORDING &&
+        fwrite(header, 1, header_size, fp) == (size_t) header_size &&
+        fwrite(data.log, 1, data.log_size, fp) == (size_t) data.log_size;
+    data.log_size = log_size;
+    file_close(fp);
+    if (!ok) {
+        log_error("Unable to write replay", filename, 0);
+        return 0;
+    }
+    log_info("Replay written", filename, data.tick);
+    return 1;
+}
+
+static void read_next_command(void)
+{
+    uint32_t value = get_varint();
+    data.next_tick += (int) (value >> COMMAND_TYPE_BITS);
+    data.next_command = (command_type) (value & ((1 << COMMAND_TYPE_BITS) - 1));
+}
+
+static void finish_playback(void)
+{
+    uint8_t expected_state[RANDOM_STATE_SIZE];
+    uint8_t actual_state[RANDOM_STATE_SIZE];
+    for (int i = 0; i < RANDOM_STATE_SIZE; i++) {
+        expected_state[i] = get_u8();
+    }
+    save_random_state(actual_state);
+    if (data.read_error || memcmp(expected_state, actual_state, RANDOM_STATE_SIZE) != 0) {
+        log_error("Replay did not end in the recorded state", 0, data.tick);
+    } else {
+        log_info("Replay finished, ticks:", 0, data.tick);
+    }
+    reset();
+}
+
+static void run_command(command_type command)
+{
+    switch (command) {
+        case COMMAND_CONSTRUCTION: {
+            building_type type = (building_type) get_varint();
+            building_type sub_type = (building_type) get_varint();
+            int road_orientation = get_u8();
+            int x_start = data.last_x + get_signed();
+            int y_start = data.last_y + get_signed();
+            int x_end = x_start + get_signed();
+            int y_end = y_start + get_signed();
+            data.last_x = x_end;
+            data.last_y = y_end;
+            if (!data.read_error) {
+                building_construction_place_from_replay(type, sub_type, road_orientation,
+                    x_start, y_start, x_end, y_end);
+            }
+            break;
+        }
+        case COMMAND_CLEAR_LAND_CONFIRMATION:
+            building_construction_clear_land_confirm(get_u8() ? 1 : -1);
+            break;
+        case COMMAND_UNDO:
+            game_undo_perform();
+            break;
+        case COMMAND_ROTATION:
+            switch (get_u8()) {
+                case REPLAY_ROTATE_LEFT: game_orientation_rotate_left(); break;
+                case REPLAY_ROTATE_RIGHT: game_orientation_rotate_right(); break;
+                case REPLAY_ROTATE_NORTH: game_orientation_rotate_north(); break;
+            }
+            break;
+        case COMMAND_TAX_CHANGE:
+            city_finance_change_tax_percentage(get_signed());
+            city_finance_estimate_taxes();
+            city_finance_calculate_totals();
+            break;
+        case COMMAND_WAGE_CHANGE:
+            city_labor_change_wages(get_signed());
+            city_finance_estimate_wages();
+            city_finance_calculate_totals();
+            break;
+        default:
+            data.read_error = 1;
+            break;
+    }
+}
+
+static void run_due_commands(void)
+{
+    while (data.state == REPLAY_PLAYING && data.next_tick <= data.tick) {
+        if (data.next_command == COMMAND_END) {
+            finish_playback();
+            return;
+        }
+        run_command(data.next_command);
+        read_next_command();
+        if (data.read_error) {
+            log_error("Replay is corrupt, playback stopped", 0, data.tick);
+            reset();
+        }
+    }
+}
+
+static uint8_t *read_replay_file(const char *filename, int *size)
+{
+    FILE *fp = file_open(filename, "rb");
+    if (!fp) {
+        return 0;
+    }
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *contents = file_size > 0 ? (uint8_t *) malloc(file_size) : 0;
+    if (contents && fread(contents, 1, file_size, fp) != (size_t) file_size) {
+        free(contents);
+        contents = 0;
+    }
+    file_close(fp);
+    *size = (int) file_size;
+    return contents;
+}
+
+int game_replay_start_playback(const char *filename)
+{
+    int size;
+    uint8_t *contents = read_replay_file(filename, &size);
+    if (!contents) {
+        log_error("Unable to read replay", filename, 0);
+        return 0;
+    }
+    int name_length = size > 6 ? contents[5] : 0;
+    if (size < 6 + name_length + RANDOM_STATE_SIZE ||
+        memcmp(contents, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 || contents[4] != REPLAY_VERSION) {
+        log_error("Not a valid replay", filename, 0);
+        free(contents);
+        return 0;
+    }
+    char saved_game[FILE_NAME_MAX];
+    memcpy(saved_game, &contents[6], name_length);
+    saved_game[name_length] = 0;
+    if (!game_file_load_saved_game(saved_game)) {
+        free(contents);
+        return 0;
+    }
+    reset();
+    save_random_state(data.random_state);
+    if (memcmp(data.random_state, &contents[6 + name_length], RANDOM_STATE_SIZE) != 0) {
+        log_error("Replay was not recorded from this saved game", saved_game, 0);
+        free(contents);
+        return 0;
+    }
+    log_info("Playing replay of", saved_game, 0);
+    data.state = REPLAY_PLAYING;
+    strncpy(data.saved_game, saved_game, FILE_NAME_MAX - 1);
+    data.log = contents;
+    data.log_size = size;
+    data.log_capacity = size;
+    data.read_pos = 6 + name_length + RANDOM_STATE_SIZE;
+    read_next_command();
+    run_due_commands();
+    return 1;
+}
+
+int game_replay_is_playing(void)
+{
+    return data.state == REPLAY_PLAYING;
+}
+
+void game_replay_tick(void)
+{
+    if (data.state == REPLAY_IDLE) {
+        return;
+    }
+    data.tick++;
+    run_due_commands();
+}
@@ -0,0 +1,111 @@
+#ifndef GAME_REPLAY_H
+#define GAME_REPLAY_H
+
+#include "building/type.h"
+
+/**
+ * @file
+ * Replay log of player commands.
+ *
+ * A replay refers to the saved game it started from and holds the commands the player gave
+ * after loading it, each stamped with the game tick it was given on. Playing it back loads
+ * the saved game and feeds the commands to the game again at the same ticks, which rebuilds
+ * the city exactly as it was played.
+ *
+ * Only the commands with a game_replay_record_* function below are recorded. Any other
+ * command that changes the city, such as labor priorities, storage orders, festivals,
+ * trade routes, imperial requests or legion orders, calls game_replay_record_unsupported_command(),
+ * which stops the recording so a replay that cannot be played back is never written.
+ * Game settings such as the difficulty are assumed to be the same during playback.
+ */
+
+typedef enum {
+    REPLAY_ROTATE_LEFT = 0,
+    REPLAY_ROTATE_RIGHT = 1,
+    REPLAY_ROTATE_NORTH = 2
+} replay_rotation;
+
+/**
+ * Starts a new recording, discarding the current one
+ * @param saved_game Saved game that was just loaded
+ */
+void game_replay_start_recording(const char *saved_game);
+
+/**
+ * Stops recording, for when the game state no longer follows from the recorded saved game
+ */
+void game_replay_stop_recording(void);
+
+/**
+ * Stops recording because the player gave a command that is not recorded,
+ * so the recording no longer follows the game
+ */
+void game_replay_record_unsupported_command(void);
+
+/**
+ * Writes the current recording next to the saved game it started from, with the extension .rpl
+ * @return Boolean true on success, false if nothing is being recorded or the file could not be written
+ */
+int game_replay_save(void);
+
+/**
+ * Loads a replay and the saved game it refers to, and starts playing it back
+ * @param filename Replay file
+ * @return Boolean true on success, false on failure
+ */
+int game_replay_start_playback(const char *filename);
+
+/**
+ * @return Boolean true while a replay is being played back
+ */
+int game_replay_is_playing(void);
+
+/**
+ * Advances the replay by one game tick: counts the tick when recording,
+ * and feeds the commands given after this tick when playing back
+ */
+void game_replay_tick(void);
+
+/**
+ * Records placing a building, road, wall or clearing land
+ * @param type Building type selected for construction
+ * @param sub_type Building type placed, for building menu entries that cycle through types
+ * @param road_orientation Road orientation of gatehouses and triumphal arches
+ * @param x_start Start X
+ * @param y_start Start Y
+ * @param x_end End X
+ * @param y_end End Y
+ */
+void game_replay_record_construction(building_type type, building_type sub_type, int road_orientation,
+    int x_start, int y_start, int x_end, int y_end);
+
+/**
+ * Records the answer to the question whether a fort or bridge should be removed
+ * @param accepted Whether the removal was accepted
+ */
+void game_replay_record_clear_land_confirmation(int accepted);
+
+/**
+ * Records undoing the last construction
+ */
+void game_replay_record_undo(void);
+
+/**
+ * Records rotating the city view
+ * @param rotation Rotation
+ */
+void game_replay_record_rotation(replay_rotation rotation);
+
+/**
+ * Records changing the tax rate
+ * @param change Change in percentage points
+ */
+void game_replay_record_tax_change(int change);
+
+/**
+ * Records changing the wages
+ * @param change Change in denarii
+ */
+void game_replay_record_wage_change(int change);
+
+#endif // GAME_REPLAY_H
@@ -0,0 +1,218 @@
+#include "saved_game_index.h"
+
+#include "core/buffer.h"
+#include "core/dir.h"
+#include "core/file.h"
+#include "core/log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_FILENAME "julius-saves.idx"
+#define INDEX_VERSION 1
+#define INDEX_HEADER_SIZE 8
+#define INDEX_ENTRY_SIZE (1 + 8 + 1 + 65 + 4 * 4)
+
+typedef struct {
+    char filename[FILE_NAME_MAX];
+    int64_t modified;
+    int is_valid;
+    int is_checked;
+    saved_game_info info;
+} index_entry;
+
+static struct {
+    int loaded;
+    int changed;
+    int num_entries;
+    int max_entries;
+    index_entry *entries;
+} data;
+
+static index_entry *add_entry(const char *filename)
+{
+    if (data.num_entries >= data.max_entries) {
+        int max_entries = data.max_entries ? 2 * data.max_entries : 64;
+        index_entry *entries = (index_entry *) realloc(data.entries, max_entries * sizeof(index_entry));
+        if (!entries) {
+            return 0;
+        }
+        data.entries = entries;
+        data.max_entries = max_entries;
+    }
+    index_entry *entry = &data.entries[data.num_entries++];
+    memset(entry, 0, sizeof(index_entry));
+    strncpy(entry->filename, filename, FILE_NAME_MAX - 1);
+    return entry;
+}
+
+static void load_entry(buffer *buf)
+{
+    char filename[FILE_NAME_MAX];
+    int length = buffer_read_u8(buf);
+    buffer_read_raw(buf, filename, length);
+    filename[length] = 0;
+    index_entry *entry = add_entry(filename);
+    if (!entry) {
+        buffer_skip(buf, INDEX_ENTRY_SIZE - 1);
+        return;
+    }
+    uint32_t modified_low = buffer_read_u32(buf);
+    uint32_t modified_high = buffer_read_u32(buf);
+    entry->modified = (int64_t) (((uint64_t) modified_high << 32) | modified_low);
+    entry->is_valid = buffer_read_u8(buf);
+    buffer_read_raw(buf, entry->info.scenario_name, sizeof(entry->info.scenario_name));
+    entry->info.month = buffer_read_i32(buf);
+    entry->info.year = buffer_read_i32(buf);
+    entry->info.population = buffer_read_i32(buf);
+    entry->info.treasury = buffer_read_i32(buf);
+}
+
+static void load_index(void)
+{
+    data.loaded = 1;
+    FILE *fp = file_open(INDEX_FILENAME, "rb");
+    if (!fp) {
+        return;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *contents = size > INDEX_HEADER_SIZE ? (uint8_t *) malloc(size) : 0;
+    if (contents && fread(contents, 1, size, fp) == (size_t) size) {
+        buffer buf;
+        buffer_init(&buf, contents, (int) size);
+        int version = buffer_read_i32(&buf);
+        int num_entries = buffer_read_i32(&buf);
+        if (version == INDEX_VERSION) {
+            for (int i = 0; i < num_entries && !buf.overflow; i++) {
+                load_entry(&buf);
+            }
+            if (buf.overflow) {
+                log_error("Saved game index is corrupt, rebuilding", 0, 0);
+                data.num_entries = 0;
+            }
+        }
+    }
+    free(contents);
+    file_close(fp);
+}
+
+static void save_entry(buffer *buf, const index_entry *entry)
+{
+    int length = (int) strlen(entry->filename);
+    buffer_write_u8(buf, (uint8_t) length);
+    buffer_write_raw(buf, entry->filename, length);
+    buffer_write_u32(buf, (uint32_t) ((uint64_t) entry->modified & 0xffffffff));
+    buffer_write_u32(buf, (uint32_t) ((uint64_t) entry->modified >> 32));
+    buffer_write_u8(buf, (uint8_t) entry->is_valid);
+    buffer_write_raw(buf, entry->info.scenario_name, sizeof(entry->info.scenario_name));
+    buffer_write_i32(buf, entry->info.month);
+    buffer_write_i32(buf, entry->info.year);
+    buffer_write_i32(buf, entry->info.population);
+    buffer_write_i32(buf, entry->info.treasury);
+}
+
+static void save_index(void)
+{
+    int size = INDEX_HEADER_SIZE;
+    for (int i = 0; i < data.num_entries; i++) {
+        size += (int) strlen(data.entries[i].filename) + INDEX_ENTRY_SIZE;
+    }
+    uint8_t *contents = (uint8_t *) malloc(size);
+    if (!contents) {
+        return;
+    }
+    buffer buf;
+    buffer_init(&buf, contents, size);
+    buffer_write_i32(&buf, INDEX_VERSION);
+    buffer_write_i32(&buf, data.num_entries);
+    for (int i = 0; i < data.num_entries; i++) {
+        save_entry(&buf, &data.entries[i]);
+    }
+    FILE *fp = file_open(INDEX_FILENAME, "wb");
+    if (fp) {
+        fwrite(contents, 1, size, fp);
+        file_close(fp);
+    } else {
+        log_error("Unable to write saved game index", INDEX_FILENAME, 0);
+    }
+    free(contents);
+}
+
+static index_entry *find_entry(const char *filename)
+{
+    for (int i = 0; i < data.num_entries; i++) {
+        if (strcmp(data.entries[i].filename, filename) == 0) {
+            return &data.entries[i];
+        }
+    }
+    return 0;
+}
+
+static int is_listed(const char *filename, const dir_listing *files)
+{
+    for (int i = 0; i < files->num_files; i++) {
+        if (strcmp(files->files[i], filename) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void saved_game_index_refresh(const dir_listing *files)
+{
+    if (!data.loaded) {
+        load_index();
+    }
+    // drop files that were removed since they were indexed
+    int num_entries = 0;
+    for (int i = 0; i < data.num_entries; i++) {
+        if (is_listed(data.entries[i].filename, files)) {
+            data.entries[num_entries] = data.entries[i];
+            data.entries[num_entries].is_checked = 0;
+            num_entries++;
+        }
+    }
+    if (num_entries != data.num_entries) {
+        data.num_entries = num_entries;
+        data.changed = 1;
+    }
+}
+
+const saved_game_info *saved_game_index_get(const char *filename)
+{
+    if (!data.loaded) {
+        load_index();
+    }
+    if (strlen(filename) > 255) {
+        return 0;
+    }
+    index_entry *entry = find_entry(filename);
+    if (entry && entry->is_checked) {
+        return entry->is_valid ? &entry->info : 0;
+    }
+    int64_t modified = file_modified_time(filename);
+    if (!entry) {
+        entry = add_entry(filename);
+        if (!entry) {
+            return 0;
+        }
+    } else if (entry->modified == modified) {
+        entry->is_checked = 1;
+        return entry->is_valid ? &entry->info : 0;
+    }
+    entry->modified = modified;
+    entry->is_checked = 1;
+    entry->is_valid = game_file_io_read_saved_game_info(filename, &entry->info);
+    data.changed = 1;
+    return entry->is_valid ? &entry->info : 0;
+}
+
+void saved_game_index_save(void)
+{
+    if (data.changed) {
+        save_index();
+        data.changed = 0;
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef GAME_SAVED_GAME_INDEX_H
+#define GAME_SAVED_GAME_INDEX_H
+
+#include "core/dir.h"
+#include "game/file_io.h"
+
+/**
+ * @file
+ * Index of saved game summaries, kept on disk and keyed by file modification time
+ * so browsing saves does not need to open every file.
+ */
+
+/**
+ * Marks all entries to be checked against the files on disk again, and drops entries
+ * of files that no longer exist. Call this whenever the list of saved games is shown.
+ * @param files Saved games currently on disk
+ */
+void saved_game_index_refresh(const dir_listing *files);
+
+/**
+ * Gets the summary of a saved game, reading the file only when it changed since it was indexed
+ * @param filename Saved game file
+ * @return Summary, valid until the next call, or NULL if the file could not be read
+ */
+const saved_game_info *saved_game_index_get(const char *filename);
+
+/**
+ * Writes the index to disk if it changed. Call this when the list of saved games is closed.
+ */
+void saved_game_index_save(void);
+
+#endif // GAME_SAVED_GAME_INDEX_H
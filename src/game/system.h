@@ -46,4 +46,53 @@ int system_use_virtual_keyboard(void);
  */
 void system_exit(void);
 
+/**
+ * Returns a millisecond counter, for measuring how long something takes
+ * @return Milliseconds elapsed since an unspecified starting point
+ */
+unsigned int system_get_ticks(void);
+
+/**
+ * Kinds of background tasks. Each kind runs independently of the others.
+ */
+typedef enum {
+    BACKGROUND_TASK_SAVE_GAME = 0,
+    BACKGROUND_TASK_LOAD_SOUNDS = 1,
+    BACKGROUND_TASK_DECODE_VIDEO = 2,
+    BACKGROUND_TASK_MAX = 3
+} background_task_type;
+
+/**
+ * Returns whether a background task is still running
+ * @param type Kind of task
+ * @return true if a task of this kind started with system_start_background_task has not finished yet
+ */
+int system_background_task_running(background_task_type type);
+
+/**
+ * Runs a task on a background thread. Only one task of each kind can run at a time.
+ * @param type Kind of task
+ * @param task Task to run
+ * @param data Data to pass to the task
+ * @return true if the task was started, false if it could not be started and the caller should run it itself
+ */
+int system_start_background_task(background_task_type type, void (*task)(void *data), void *data);
+
+/**
+ * Waits until the background task of the given kind has finished
+ * @param type Kind of task
+ */
+void system_wait_for_background_task(background_task_type type);
+
+/**
+ * Runs a task for every item, spread over worker threads, and waits until all items are done.
+ * The calling thread is one of the workers.
+ * @param task Task to run, called with the item index and the index of the worker running it
+ * @param num_items Number of items
+ * @param max_workers Maximum number of workers to use
+ * @param data Data to pass to the task
+ * @return Number of workers used, or 0 if no worker threads could be started and the caller should run the items itself
+ */
+int system_run_parallel_tasks(void (*task)(int item, int worker, void *data), int num_items, int max_workers, void *data);
+
 #endif // GAME_SYSTEM_H
@@ -32,6 +32,7 @@
 #include "figure/formation.h"
 #include "figuretype/crime.h"
 #include "game/file.h"
+#include "game/replay.h"
 #include "game/settings.h"
 #include "game/time.h"
 #include "game/tutorial.h"
@@ -99,7 +100,7 @@ static void advance_month(void)
     city_festival_update();
     tutorial_on_month_tick();
     if (setting_monthly_autosave()) {
-        game_file_write_saved_game("autosave.sav");
+        game_file_write_saved_game_in_background("autosave.sav");
     }
 }
 
@@ -180,4 +181,5 @@ void game_tick_run(void)
     scenario_gladiator_revolt_process();
     scenario_emperor_change_process();
     city_victory_check();
+    game_replay_tick();
 }
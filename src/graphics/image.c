@@ -694,6 +694,65 @@ void image_draw_letter(font_t font, int letter_id, int x, int y, color_t color)
     }
 }
 
+static void set_buffer_pixel(color_t *pixels, uint8_t *mask, int index, color_t color)
+{
+    pixels[index] = color;
+    mask[index] = 1;
+}
+
+int image_draw_letter_to_buffer(int letter_id, int x, int y, color_t color,
+    color_t *pixels, uint8_t *mask, int buffer_width)
+{
+    const image *img = image_letter(letter_id);
+    const color_t *data = image_data_letter(letter_id);
+    if (!data) {
+        return 1;
+    }
+    if (letter_id >= IMAGE_FONT_MULTIBYTE_OFFSET) {
+        // blended with what is below, so it cannot be drawn ahead of time
+        return 0;
+    }
+    if (img->draw.is_fully_compressed) {
+        for (int dy = 0; dy < img->height; dy++) {
+            int index = (y + dy) * buffer_width + x;
+            int dx = 0;
+            while (dx < img->width) {
+                color_t b = *data;
+                data++;
+                if (b == 255) {
+                    // transparent pixels to skip
+                    dx += *data;
+                    data++;
+                } else {
+                    for (color_t i = 0; i < b; i++, dx++, data++) {
+                        set_buffer_pixel(pixels, mask, index + dx, color ? color : *data);
+                    }
+                }
+            }
+        }
+    } else {
+        int can_be_transparent = color || img->draw.type == IMAGE_TYPE_WITH_TRANSPARENCY || img->draw.is_external;
+        for (int dy = 0; dy < img->height; dy++) {
+            int index = (y + dy) * buffer_width + x;
+            for (int dx = 0; dx < img->width; dx++, data++) {
+                if (!can_be_transparent || *data != COLOR_TRANSPARENT) {
+                    set_buffer_pixel(pixels, mask, index + dx, color ? color : *data);
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+void image_draw_compressed_buffer(const color_t *data, int x, int y, int width, int height)
+{
+    image img;
+    memset(&img, 0, sizeof(img));
+    img.width = width;
+    img.height = height;
+    draw_compressed(&img, data, x, y, height);
+}
+
 void image_draw_fullscreen_background(int image_id)
 {
     int s_width = screen_width();
@@ -12,6 +12,9 @@ void image_draw_masked(int image_id, int x, int y, color_t color_mask);
 void image_draw_blend(int image_id, int x, int y, color_t color);
 void image_draw_blend_alpha(int image_id, int x, int y, color_t color);
 void image_draw_letter(font_t font, int letter_id, int x, int y, color_t color);
+int image_draw_letter_to_buffer(int letter_id, int x, int y, color_t color,
+    color_t *pixels, uint8_t *mask, int buffer_width);
+void image_draw_compressed_buffer(const color_t *data, int x, int y, int width, int height);
 
 void image_draw_fullscreen_background(int image_id);
 
@@ -8,7 +8,11 @@
 #include "graphics/image_button.h"
 #include "graphics/window.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #define MAX_LINKS 50
+#define MAX_LAYOUTS 8
 
 static void text_scroll(int is_down, int num_lines);
 
@@ -33,6 +37,38 @@ static const font_definition *link_font_def;
 
 static uint8_t tmp_line[200];
 
+typedef struct {
+    int text_offset;
+    int x_offset;
+    int image_id;
+    int has_link;
+} layout_line;
+
+typedef struct {
+    int is_valid;
+    const uint8_t *source;
+    uint32_t hash;
+    int length;
+    int box_width;
+    int measure_only;
+    const font_definition *normal_font;
+    const font_definition *link_font;
+    int letters_version;
+    unsigned int last_used;
+    int total_lines;
+    layout_line *lines;
+    int num_lines;
+    int lines_capacity;
+    uint8_t *text;
+    int text_size;
+    int text_capacity;
+} text_layout;
+
+static struct {
+    text_layout layouts[MAX_LAYOUTS];
+    unsigned int use_counter;
+} layout_cache;
+
 static struct {
     int x_text;
     int y_text;
@@ -261,15 +297,52 @@ static void draw_line(const uint8_t *str, int x, int y, color_t color, int measu
     }
 }
 
-static int draw_text(const uint8_t *text, int x_offset, int y_offset,
-                     int box_width, int height_lines, color_t color, int measure_only)
+typedef struct {
+    int x_offset;
+    int y;
+    int box_width;
+    int height_lines;
+    color_t color;
+    int measure_only;
+} render_state;
+
+static void render_line(render_state *state, int line, const uint8_t *str, int x_line_offset, int image_id)
+{
+    int outside_viewport = 0;
+    if (!state->measure_only) {
+        if (line < data.scroll_position || line >= data.scroll_position + state->height_lines) {
+            outside_viewport = 1;
+        }
+    }
+    if (!outside_viewport) {
+        draw_line(str, x_line_offset + state->x_offset, state->y, state->color, state->measure_only);
+    }
+    if (image_id) {
+        const image *img = image_get(image_id);
+        int image_offset_x = state->x_offset + (state->box_width - img->width) / 2 - 4;
+        if (line < state->height_lines + data.scroll_position) {
+            if (line >= data.scroll_position) {
+                image_draw(image_id, image_offset_x, state->y + 8);
+            } else {
+                image_draw(image_id, image_offset_x, state->y + 8 - 16 * (data.scroll_position - line));
+            }
+        }
+    }
+    if (!outside_viewport) {
+        state->y += 16;
+    }
+}
+
+// Breaks the text into lines and passes each one to add_line, together with the image to draw there.
+// Returns the number of lines, including those taken up by images.
+static int layout_text(const uint8_t *text, int box_width, int measure_only,
+    void (*add_line)(void *data, int line, const uint8_t *str, int x_line_offset, int image_id), void *add_line_data)
 {
     int image_height_lines = 0;
     int image_id = 0;
     int lines_before_image = 0;
     int paragraph = 0;
     int has_more_characters = 1;
-    int y = y_offset;
     int guard = 0;
     int line = 0;
     int num_lines = 0;
@@ -338,43 +411,149 @@ static int draw_text(const uint8_t *text, int x_offset, int y_offset,
             }
         }
 
-        int outside_viewport = 0;
-        if (!measure_only) {
-            if (line < data.scroll_position || line >= data.scroll_position + height_lines) {
-                outside_viewport = 1;
-            }
-        }
-        if (!outside_viewport) {
-            draw_line(tmp_line, x_line_offset + x_offset, y, color, measure_only);
-        }
+        int line_image_id = 0;
         if (!measure_only) {
             if (image_id) {
                 if (lines_before_image) {
                     lines_before_image--;
                 } else {
-                    const image *img = image_get(image_id);
-                    image_height_lines = img->height / 16 + 2;
-                    int image_offset_x = x_offset + (box_width - img->width) / 2 - 4;
-                    if (line < height_lines + data.scroll_position) {
-                        if (line >= data.scroll_position) {
-                            image_draw(image_id, image_offset_x, y + 8);
-                        } else {
-                            image_draw(image_id, image_offset_x, y + 8 - 16 * (data.scroll_position - line));
-                        }
-                    }
+                    image_height_lines = image_get(image_id)->height / 16 + 2;
+                    line_image_id = image_id;
                     image_id = 0;
                 }
             }
         }
+        add_line(add_line_data, line, tmp_line, x_line_offset, line_image_id);
         line++;
         num_lines++;
-        if (!outside_viewport) {
-            y += 16;
-        }
     }
     return num_lines;
 }
 
+static void render_line_now(void *state, int line, const uint8_t *str, int x_line_offset, int image_id)
+{
+    render_line((render_state *) state, line, str, x_line_offset, image_id);
+}
+
+static void add_layout_line(void *layout_data, int line, const uint8_t *str, int x_line_offset, int image_id)
+{
+    text_layout *layout = (text_layout *) layout_data;
+    if (!layout->is_valid) {
+        return;
+    }
+    int length = 0;
+    while (length < (int) sizeof(tmp_line) - 1 && str[length]) {
+        length++;
+    }
+    if (layout->num_lines >= layout->lines_capacity) {
+        int capacity = layout->lines_capacity ? 2 * layout->lines_capacity : 64;
+        layout_line *lines = (layout_line *) realloc(layout->lines, sizeof(layout_line) * capacity);
+        if (!lines) {
+            layout->is_valid = 0;
+            return;
+        }
+        layout->lines = lines;
+        layout->lines_capacity = capacity;
+    }
+    if (layout->text_size + length + 1 > layout->text_capacity) {
+        int capacity = layout->text_capacity ? 2 * layout->text_capacity : 2048;
+        while (capacity < layout->text_size + length + 1) {
+            capacity *= 2;
+        }
+        uint8_t *text = (uint8_t *) realloc(layout->text, capacity);
+        if (!text) {
+            layout->is_valid = 0;
+            return;
+        }
+        layout->text = text;
+        layout->text_capacity = capacity;
+    }
+    layout_line *l = &layout->lines[layout->num_lines++];
+    l->text_offset = layout->text_size;
+    l->x_offset = x_line_offset;
+    l->image_id = image_id;
+    l->has_link = 0;
+    for (const uint8_t *c = str; *c; c++) {
+        if (*c == '@') {
+            l->has_link = 1;
+            break;
+        }
+    }
+    memcpy(&layout->text[layout->text_size], str, length);
+    layout->text[layout->text_size + length] = 0;
+    layout->text_size += length + 1;
+}
+
+static uint32_t hash_text(const uint8_t *text, int *length)
+{
+    uint32_t hash = 2166136261u;
+    *length = 0;
+    while (text[*length]) {
+        hash = (hash ^ text[*length]) * 16777619u;
+        (*length)++;
+    }
+    return hash;
+}
+
+static text_layout *get_layout(const uint8_t *text, int box_width, int measure_only)
+{
+    int length;
+    uint32_t hash = hash_text(text, &length);
+    int letters_version = image_letters_version();
+    text_layout *unused = &layout_cache.layouts[0];
+    for (int i = 0; i < MAX_LAYOUTS; i++) {
+        text_layout *layout = &layout_cache.layouts[i];
+        if (layout->is_valid && layout->source == text && layout->hash == hash && layout->length == length &&
+            layout->box_width == box_width && layout->measure_only == measure_only &&
+            layout->normal_font == normal_font_def && layout->link_font == link_font_def &&
+            layout->letters_version == letters_version) {
+            layout->last_used = ++layout_cache.use_counter;
+            return layout;
+        }
+        if (layout->last_used < unused->last_used) {
+            unused = layout;
+        }
+    }
+    text_layout *layout = unused;
+    layout->is_valid = 1;
+    layout->source = text;
+    layout->hash = hash;
+    layout->length = length;
+    layout->box_width = box_width;
+    layout->measure_only = measure_only;
+    layout->normal_font = normal_font_def;
+    layout->link_font = link_font_def;
+    layout->letters_version = letters_version;
+    layout->last_used = ++layout_cache.use_counter;
+    layout->num_lines = 0;
+    layout->text_size = 0;
+    layout->total_lines = layout_text(text, box_width, measure_only, add_layout_line, layout);
+    return layout->is_valid ? layout : 0;
+}
+
+static int draw_text(const uint8_t *text, int x_offset, int y_offset,
+                     int box_width, int height_lines, color_t color, int measure_only)
+{
+    render_state state = { x_offset, y_offset, box_width, height_lines, color, measure_only };
+    const text_layout *layout = get_layout(text, box_width, measure_only);
+    if (!layout) {
+        return layout_text(text, box_width, measure_only, render_line_now, &state);
+    }
+    for (int line = 0; line < layout->num_lines; line++) {
+        const layout_line *l = &layout->lines[line];
+        if (measure_only && !l->has_link) {
+            // measuring only adds links, and there are none on this line
+            state.y += 16;
+            continue;
+        }
+        // draw_line may read past the end of the line, where tmp_line is cleared
+        memset(tmp_line, 0, sizeof(tmp_line));
+        string_copy(&layout->text[l->text_offset], tmp_line, sizeof(tmp_line));
+        render_line(&state, line, tmp_line, l->x_offset, l->image_id);
+    }
+    return layout->total_lines;
+}
+
 int rich_text_draw(const uint8_t *text, int x_offset, int y_offset, int box_width, int height_lines, int measure_only)
 {
     return draw_text(text, x_offset, y_offset, box_width, height_lines, 0, measure_only);
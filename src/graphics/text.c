@@ -5,10 +5,14 @@
 #include "graphics/graphics.h"
 #include "graphics/image.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #define ELLIPSIS_LENGTH 4
 
+#define GLYPH_RUN_CACHE_SIZE 256
+#define GLYPH_RUN_MAX_LENGTH 64
+
 static uint8_t tmp_line[200];
 
 static struct {
@@ -30,6 +34,43 @@ static struct {
     int width[FONT_TYPES_MAX];
 } ellipsis = { {'.', '.', '.', 0} };
 
+typedef struct {
+    int letter_id;
+    int16_t x;
+    int16_t y_offset;
+} glyph;
+
+typedef struct {
+    color_t *data;
+    color_t color;
+    int x_offset;
+    int y_offset;
+    int width;
+    int height;
+} text_surface;
+
+typedef struct {
+    int in_use;
+    uint32_t hash;
+    font_t font;
+    int length;
+    uint8_t text[GLYPH_RUN_MAX_LENGTH];
+    int width;
+    int draw_width;
+    int num_characters;
+    int num_glyphs;
+    glyph glyphs[GLYPH_RUN_MAX_LENGTH];
+    int times_drawn;
+    color_t last_color;
+    int no_surface;
+    text_surface surface;
+} glyph_run;
+
+static struct {
+    glyph_run runs[GLYPH_RUN_CACHE_SIZE];
+    int letters_version;
+} glyph_run_cache;
+
 static int get_ellipsis_width(font_t font)
 {
     if (!ellipsis.width[font]) {
@@ -83,7 +124,7 @@ void text_draw_cursor(int x_offset, int y_offset, int is_insert)
     }
 }
 
-int text_get_width(const uint8_t *str, font_t font)
+static int measure_width(const uint8_t *str, font_t font)
 {
     const font_definition *def = font_definition_for(font);
     int maxlen = 10000;
@@ -104,6 +145,85 @@ int text_get_width(const uint8_t *str, font_t font)
     return width;
 }
 
+static void layout_glyph_run(glyph_run *run, const uint8_t *str, int length, font_t font)
+{
+    const font_definition *def = font_definition_for(font);
+    int current_x = 0;
+    run->num_characters = 0;
+    run->num_glyphs = 0;
+    while (length > 0) {
+        int num_bytes = 1;
+        if (*str >= ' ') {
+            int letter_id = font_letter_id(def, str, &num_bytes);
+            if (*str == ' ' || *str == '_' || letter_id < 0) {
+                current_x += def->space_width_draw;
+            } else {
+                const image *img = image_letter(letter_id);
+                glyph *g = &run->glyphs[run->num_glyphs++];
+                g->letter_id = letter_id;
+                g->x = current_x;
+                g->y_offset = def->image_y_offset(*str, img->height, def->line_height);
+                current_x += def->letter_spacing_draw + img->width;
+            }
+        }
+        str += num_bytes;
+        length -= num_bytes;
+        run->num_characters++;
+    }
+    run->draw_width = current_x;
+}
+
+static void clear_glyph_run(glyph_run *run)
+{
+    free(run->surface.data);
+    memset(run, 0, sizeof(glyph_run));
+}
+
+static void clear_cache(void)
+{
+    for (int i = 0; i < GLYPH_RUN_CACHE_SIZE; i++) {
+        clear_glyph_run(&glyph_run_cache.runs[i]);
+    }
+    memset(ellipsis.width, 0, sizeof(ellipsis.width));
+    glyph_run_cache.letters_version = image_letters_version();
+}
+
+static glyph_run *get_glyph_run(const uint8_t *str, font_t font)
+{
+    if (glyph_run_cache.letters_version != image_letters_version()) {
+        clear_cache();
+    }
+    uint32_t hash = 2166136261u ^ font;
+    int length = 0;
+    while (str[length]) {
+        if (length >= GLYPH_RUN_MAX_LENGTH) {
+            return 0;
+        }
+        hash = (hash ^ str[length]) * 16777619u;
+        length++;
+    }
+    glyph_run *run = &glyph_run_cache.runs[hash % GLYPH_RUN_CACHE_SIZE];
+    if (run->in_use && run->hash == hash && run->font == font && run->length == length &&
+        memcmp(run->text, str, length) == 0) {
+        return run;
+    }
+    clear_glyph_run(run);
+    run->in_use = 1;
+    run->hash = hash;
+    run->font = font;
+    run->length = length;
+    memcpy(run->text, str, length);
+    run->width = measure_width(str, font);
+    layout_glyph_run(run, str, length, font);
+    return run;
+}
+
+int text_get_width(const uint8_t *str, font_t font)
+{
+    const glyph_run *run = get_glyph_run(str, font);
+    return run ? run->width : measure_width(str, font);
+}
+
 unsigned int text_get_max_length_for_width(const uint8_t *str, int length, font_t font, unsigned int requested_width, int invert)
 {
     const font_definition *def = font_definition_for(font);
@@ -213,8 +333,137 @@ void text_draw_centered(const uint8_t *str, int x, int y, int box_width, font_t
     text_draw(str, offset + x, y, font, color);
 }
 
+static color_t *compress_surface(const color_t *pixels, const uint8_t *mask, int width, int height)
+{
+    // Same format as compressed images: a run of 255 and a count skips transparent pixels,
+    // any other count is followed by that many pixels
+    color_t *data = (color_t *) malloc(sizeof(color_t) * (2 * width * height + 2 * height));
+    if (!data) {
+        return 0;
+    }
+    int length = 0;
+    for (int y = 0; y < height; y++) {
+        int x = 0;
+        while (x < width) {
+            int index = y * width + x;
+            int count = 0;
+            if (!mask[index]) {
+                while (x + count < width && !mask[index + count]) {
+                    count++;
+                }
+                data[length++] = 255;
+                data[length++] = count;
+            } else {
+                while (x + count < width && count < 254 && mask[index + count]) {
+                    count++;
+                }
+                data[length++] = count;
+                memcpy(&data[length], &pixels[index], sizeof(color_t) * count);
+                length += count;
+            }
+            x += count;
+        }
+    }
+    color_t *shrunk = (color_t *) realloc(data, sizeof(color_t) * length);
+    return shrunk ? shrunk : data;
+}
+
+static int create_surface(glyph_run *run, color_t color)
+{
+    int min_x = 0;
+    int min_y = 0;
+    int max_x = 0;
+    int max_y = 0;
+    for (int i = 0; i < run->num_glyphs; i++) {
+        const glyph *g = &run->glyphs[i];
+        const image *img = image_letter(g->letter_id);
+        int y = -g->y_offset;
+        if (i == 0 || g->x < min_x) {
+            min_x = g->x;
+        }
+        if (i == 0 || y < min_y) {
+            min_y = y;
+        }
+        if (i == 0 || g->x + img->width > max_x) {
+            max_x = g->x + img->width;
+        }
+        if (i == 0 || y + img->height > max_y) {
+            max_y = y + img->height;
+        }
+    }
+    int width = max_x - min_x;
+    int height = max_y - min_y;
+    if (width <= 0 || height <= 0) {
+        return 0;
+    }
+    color_t *pixels = (color_t *) malloc(sizeof(color_t) * width * height);
+    uint8_t *mask = (uint8_t *) calloc(width * height, sizeof(uint8_t));
+    int ok = pixels && mask;
+    for (int i = 0; ok && i < run->num_glyphs; i++) {
+        const glyph *g = &run->glyphs[i];
+        ok = image_draw_letter_to_buffer(g->letter_id, g->x - min_x, -g->y_offset - min_y, color,
+            pixels, mask, width);
+    }
+    if (ok) {
+        run->surface.data = compress_surface(pixels, mask, width, height);
+        run->surface.color = color;
+        run->surface.x_offset = min_x;
+        run->surface.y_offset = min_y;
+        run->surface.width = width;
+        run->surface.height = height;
+    }
+    free(pixels);
+    free(mask);
+    return run->surface.data != 0;
+}
+
+static int has_surface(glyph_run *run, color_t color)
+{
+    if (run->surface.data && run->surface.color == color) {
+        return 1;
+    }
+    if (run->no_surface) {
+        return 0;
+    }
+    // only labels that are drawn again in the same color are worth keeping as a surface
+    if (!run->times_drawn || run->last_color != color) {
+        run->times_drawn = 1;
+        run->last_color = color;
+        return 0;
+    }
+    free(run->surface.data);
+    run->surface.data = 0;
+    if (!create_surface(run, color)) {
+        run->no_surface = 1;
+        return 0;
+    }
+    return 1;
+}
+
+static int draw_glyph_run(glyph_run *run, int x, int y, font_t font, color_t color)
+{
+    const font_definition *def = font_definition_for(font);
+    if (has_surface(run, color)) {
+        image_draw_compressed_buffer(run->surface.data, x + run->surface.x_offset, y + run->surface.y_offset,
+            run->surface.width, run->surface.height);
+    } else {
+        for (int i = 0; i < run->num_glyphs; i++) {
+            const glyph *g = &run->glyphs[i];
+            image_draw_letter(def->font, g->letter_id, x + g->x, y - g->y_offset, color);
+        }
+    }
+    input_cursor.position += run->num_characters;
+    return run->draw_width + def->space_width_draw;
+}
+
 int text_draw(const uint8_t *str, int x, int y, font_t font, color_t color)
 {
+    if (!input_cursor.capture) {
+        glyph_run *run = get_glyph_run(str, font);
+        if (run) {
+            return draw_glyph_run(run, x, y, font, color);
+        }
+    }
     const font_definition *def = font_definition_for(font);
 
     int length = string_length(str);
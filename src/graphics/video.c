@@ -5,11 +5,26 @@
 #include "core/smacker.h"
 #include "core/time.h"
 #include "game/settings.h"
+#include "game/system.h"
 #include "graphics/graphics.h"
 #include "sound/device.h"
 #include "sound/music.h"
 #include "sound/speech.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#define PREFETCH_FRAMES 8
+
+typedef struct {
+    smacker_frame_status status;
+    uint8_t *video;
+    color_t palette[256];
+    uint8_t *audio;
+    int audio_len;
+    int audio_capacity;
+} video_frame;
+
 static struct {
     int is_playing;
     int is_ended;
@@ -22,6 +37,7 @@ static struct {
         int micros_per_frame;
         time_millis start_render_millis;
         int current_frame;
+        int frame_size;
     } video;
     struct {
         int has_audio;
@@ -29,14 +45,142 @@ static struct {
         int channels;
         int rate;
     } audio;
+    struct {
+        video_frame frames[PREFETCH_FRAMES];
+        int shown;
+        int first;
+        int decoded;
+        int batch_start;
+        int batch_size;
+        int batch_running;
+    } prefetch;
 } data;
 
+static void wait_for_prefetch(void)
+{
+    if (data.prefetch.batch_running) {
+        // a batch is only a few frames long, so this does not take long
+        system_wait_for_background_task(BACKGROUND_TASK_DECODE_VIDEO);
+        data.prefetch.batch_running = 0;
+    }
+}
+
+static void free_frames(void)
+{
+    for (int i = 0; i < PREFETCH_FRAMES; i++) {
+        free(data.prefetch.frames[i].video);
+        free(data.prefetch.frames[i].audio);
+    }
+    memset(&data.prefetch, 0, sizeof(data.prefetch));
+}
+
+static int allocate_frames(void)
+{
+    for (int i = 0; i < PREFETCH_FRAMES; i++) {
+        data.prefetch.frames[i].video = (uint8_t *) malloc(data.video.frame_size);
+        if (!data.prefetch.frames[i].video) {
+            free_frames();
+            return 0;
+        }
+    }
+    return 1;
+}
+
 static void close_smk(void)
 {
     if (data.s) {
+        wait_for_prefetch();
         smacker_close(data.s);
         data.s = 0;
+        free_frames();
+    }
+}
+
+static void copy_decoded_frame(video_frame *frame)
+{
+    memcpy(frame->video, smacker_get_frame_video(data.s), data.video.frame_size);
+    memcpy(frame->palette, smacker_get_frame_palette(data.s), sizeof(frame->palette));
+    frame->audio_len = 0;
+    if (data.audio.has_audio) {
+        int audio_len = smacker_get_frame_audio_size(data.s, 0);
+        if (audio_len > frame->audio_capacity) {
+            uint8_t *audio = (uint8_t *) realloc(frame->audio, audio_len);
+            if (!audio) {
+                return;
+            }
+            frame->audio = audio;
+            frame->audio_capacity = audio_len;
+        }
+        if (audio_len > 0) {
+            memcpy(frame->audio, smacker_get_frame_audio(data.s, 0), audio_len);
+            frame->audio_len = audio_len;
+        }
+    }
+}
+
+static int decode_next_frame(video_frame *frame)
+{
+    frame->status = smacker_next_frame(data.s);
+    if (frame->status == SMACKER_FRAME_OK) {
+        copy_decoded_frame(frame);
+        return 1;
+    }
+    return 0;
+}
+
+static void decode_batch(void *unused)
+{
+    for (int i = 0; i < data.prefetch.batch_size; i++) {
+        if (!decode_next_frame(&data.prefetch.frames[(data.prefetch.batch_start + i) % PREFETCH_FRAMES])) {
+            // nothing follows the last frame or a broken one
+            data.prefetch.batch_size = i + 1;
+            break;
+        }
+    }
+}
+
+static void finish_prefetch(void)
+{
+    if (data.prefetch.batch_running && !system_background_task_running(BACKGROUND_TASK_DECODE_VIDEO)) {
+        data.prefetch.decoded += data.prefetch.batch_size;
+        data.prefetch.batch_running = 0;
+    }
+}
+
+static void start_prefetch(void)
+{
+    if (data.prefetch.batch_running) {
+        return;
+    }
+    int last = (data.prefetch.first + data.prefetch.decoded - 1) % PREFETCH_FRAMES;
+    if (data.prefetch.decoded > 0 && data.prefetch.frames[last].status != SMACKER_FRAME_OK) {
+        return;
+    }
+    // the frame on screen is kept until the next one is shown
+    int free_slots = PREFETCH_FRAMES - 1 - data.prefetch.decoded;
+    if (free_slots <= 0) {
+        return;
+    }
+    data.prefetch.batch_start = (data.prefetch.first + data.prefetch.decoded) % PREFETCH_FRAMES;
+    data.prefetch.batch_size = free_slots;
+    data.prefetch.batch_running = system_start_background_task(BACKGROUND_TASK_DECODE_VIDEO, decode_batch, 0);
+}
+
+static const video_frame *next_frame(void)
+{
+    if (!data.prefetch.decoded) {
+        if (data.prefetch.batch_running) {
+            // still decoding: try again on the next draw
+            return 0;
+        }
+        // no thread available: decode the frame ourselves
+        decode_next_frame(&data.prefetch.frames[data.prefetch.first]);
+        data.prefetch.decoded = 1;
     }
+    data.prefetch.shown = data.prefetch.first;
+    data.prefetch.first = (data.prefetch.first + 1) % PREFETCH_FRAMES;
+    data.prefetch.decoded--;
+    return &data.prefetch.frames[data.prefetch.shown];
 }
 
 static int load_smk(const char *filename)
@@ -61,6 +205,7 @@ static int load_smk(const char *filename)
     data.video.y_scale = y_scale;
     data.video.current_frame = 0;
     data.video.micros_per_frame = micros_per_frame;
+    data.video.frame_size = width * height;
 
     data.audio.has_audio = 0;
     if (setting_sound(SOUND_EFFECTS)->enabled) {
@@ -74,10 +219,19 @@ static int load_smk(const char *filename)
         }
     }
 
+    if (!allocate_frames()) {
+        smacker_close(data.s);
+        data.s = 0;
+        return 0;
+    }
     if (smacker_first_frame(data.s) != SMACKER_FRAME_OK) {
         close_smk();
         return 0;
     }
+    copy_decoded_frame(&data.prefetch.frames[0]);
+    data.prefetch.frames[0].status = SMACKER_FRAME_OK;
+    data.prefetch.shown = 0;
+    data.prefetch.first = 1;
     return 1;
 }
 
@@ -112,14 +266,12 @@ void video_init(void)
 {
     data.video.start_render_millis = time_get_millis();
 
-    if (data.audio.has_audio) {
-        int audio_len = smacker_get_frame_audio_size(data.s, 0);
-        if (audio_len > 0) {
-            sound_device_use_custom_music_player(
-                data.audio.bitdepth, data.audio.channels, data.audio.rate,
-                smacker_get_frame_audio(data.s, 0), audio_len
-            );
-        }
+    const video_frame *frame = &data.prefetch.frames[data.prefetch.shown];
+    if (data.audio.has_audio && frame->audio_len > 0) {
+        sound_device_use_custom_music_player(
+            data.audio.bitdepth, data.audio.channels, data.audio.rate,
+            frame->audio, frame->audio_len
+        );
     }
 }
 
@@ -147,17 +299,36 @@ void video_shutdown(void)
     }
 }
 
+static void draw_line(color_t *pixel, const uint8_t *line, const color_t *pal, int width)
+{
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        pixel[x] = pal[line[x]];
+        pixel[x + 1] = pal[line[x + 1]];
+        pixel[x + 2] = pal[line[x + 2]];
+        pixel[x + 3] = pal[line[x + 3]];
+    }
+    for (; x < width; x++) {
+        pixel[x] = pal[line[x]];
+    }
+}
+
 void video_draw(int x_offset, int y_offset)
 {
     if (!data.s) {
         return;
     }
+    finish_prefetch();
     time_millis now_millis = time_get_millis();
 
     int frame_no = (now_millis - data.video.start_render_millis) * 1000 / data.video.micros_per_frame;
     int draw_frame = data.video.current_frame == 0;
     while (frame_no > data.video.current_frame) {
-        if (smacker_next_frame(data.s) != SMACKER_FRAME_OK) {
+        const video_frame *frame = next_frame();
+        if (!frame) {
+            break;
+        }
+        if (frame->status != SMACKER_FRAME_OK) {
             close_smk();
             data.is_ended = 1;
             data.is_playing = 0;
@@ -167,13 +338,11 @@ void video_draw(int x_offset, int y_offset)
         data.video.current_frame++;
         draw_frame = 1;
 
-        if (data.audio.has_audio) {
-            int audio_len = smacker_get_frame_audio_size(data.s, 0);
-            if (audio_len > 0) {
-                sound_device_write_custom_music_data(smacker_get_frame_audio(data.s, 0), audio_len);
-            }
+        if (data.audio.has_audio && frame->audio_len > 0) {
+            sound_device_write_custom_music_data(frame->audio, frame->audio_len);
         }
     }
+    start_prefetch();
     if (!draw_frame) {
         return;
     }
@@ -181,17 +350,21 @@ void video_draw(int x_offset, int y_offset)
     if (!clip->is_visible) {
         return;
     }
-    const unsigned char *frame = smacker_get_frame_video(data.s);
-    const uint32_t *pal = smacker_get_frame_palette(data.s);
-    if (frame && pal) {
-        for (int y = clip->clipped_pixels_top; y < clip->visible_pixels_y; y++) {
-            color_t *pixel = graphics_get_pixel(x_offset + clip->clipped_pixels_left, y + y_offset + clip->clipped_pixels_top);
-            int video_y = data.video.y_scale == SMACKER_Y_SCALE_NONE ? y : y / 2;
-            const unsigned char *line = frame + (video_y * data.video.width);
-            for (int x = clip->clipped_pixels_left; x < clip->visible_pixels_x; x++) {
-                *pixel = pal[line[x]];
-                ++pixel;
-            }
+    const video_frame *frame = &data.prefetch.frames[data.prefetch.shown];
+    const color_t *pal = frame->palette;
+    int width = clip->visible_pixels_x - clip->clipped_pixels_left;
+    const unsigned char *line = frame->video + clip->clipped_pixels_left;
+    color_t *previous = 0;
+    for (int y = clip->clipped_pixels_top; y < clip->visible_pixels_y; y++) {
+        color_t *pixel = graphics_get_pixel(x_offset + clip->clipped_pixels_left, y + y_offset + clip->clipped_pixels_top);
+        if (data.video.y_scale == SMACKER_Y_SCALE_NONE) {
+            draw_line(pixel, line + y * data.video.width, pal, width);
+        } else if ((y & 1) && previous) {
+            // scaled videos show every line twice: copy the one just drawn
+            memcpy(pixel, previous, sizeof(color_t) * width);
+        } else {
+            draw_line(pixel, line + (y / 2) * data.video.width, pal, width);
         }
+        previous = pixel;
     }
 }
@@ -6,7 +6,9 @@
 #include "city/view.h"
 #include "city/warning.h"
 #include "figure/formation.h"
+#include "game/file.h"
 #include "game/orientation.h"
+#include "game/replay.h"
 #include "game/settings.h"
 #include "game/state.h"
 #include "game/system.h"
@@ -416,6 +418,26 @@ static void handle_bookmark(int number, int with_modifier)
     }
 }
 
+static void take_snapshot(int as_replay)
+{
+    if (!window_is(WINDOW_CITY)) {
+        return;
+    }
+    if (as_replay) {
+        game_replay_save();
+    } else {
+        game_file_write_snapshot();
+    }
+}
+
+static void restore_snapshot(int drop_newest)
+{
+    exit_military_command();
+    if (window_is(WINDOW_CITY) && game_file_load_snapshot(drop_newest)) {
+        window_invalidate();
+    }
+}
+
 static void take_screenshot(int full_city)
 {
     graphics_save_screenshot(full_city);
@@ -435,6 +457,8 @@ void hotkey_func(int f_number, int with_any_modifier, int with_ctrl)
         case 7: system_resize(640, 480); break;
         case 8: system_resize(800, 600); break;
         case 9: system_resize(1024, 768); break;
+        case 10: take_snapshot(with_ctrl); break;
+        case 11: restore_snapshot(with_ctrl); break;
         case 12: take_screenshot(with_ctrl); break;
     }
 }
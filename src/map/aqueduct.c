@@ -1,6 +1,7 @@
 #include "aqueduct.h"
 
 #include "map/grid.h"
+#include "map/water_supply.h"
 
 /**
  * The aqueduct grid is used in two ways:
@@ -18,29 +19,33 @@ int map_aqueduct_at(int grid_offset)
 
 void map_aqueduct_set(int grid_offset, int value)
 {
+    if (aqueduct.items[grid_offset] != value) {
+        map_water_supply_invalidate_tile(grid_offset);
+    }
     aqueduct.items[grid_offset] = value;
 }
 
 void map_aqueduct_remove(int grid_offset)
 {
-    aqueduct.items[grid_offset] = 0;
+    map_aqueduct_set(grid_offset, 0);
     if (aqueduct.items[grid_offset + map_grid_delta(0, -1)] == 5) {
-        aqueduct.items[grid_offset + map_grid_delta(0, -1)] = 1;
+        map_aqueduct_set(grid_offset + map_grid_delta(0, -1), 1);
     }
     if (aqueduct.items[grid_offset + map_grid_delta(1, 0)] == 6) {
-        aqueduct.items[grid_offset + map_grid_delta(1, 0)] = 2;
+        map_aqueduct_set(grid_offset + map_grid_delta(1, 0), 2);
     }
     if (aqueduct.items[grid_offset + map_grid_delta(0, 1)] == 5) {
-        aqueduct.items[grid_offset + map_grid_delta(0, 1)] = 3;
+        map_aqueduct_set(grid_offset + map_grid_delta(0, 1), 3);
     }
     if (aqueduct.items[grid_offset + map_grid_delta(-1, 0)] == 6) {
-        aqueduct.items[grid_offset + map_grid_delta(-1, 0)] = 4;
+        map_aqueduct_set(grid_offset + map_grid_delta(-1, 0), 4);
     }
 }
 
 void map_aqueduct_clear(void)
 {
     map_grid_clear_u8(aqueduct.items);
+    map_water_supply_invalidate_all();
 }
 
 void map_aqueduct_backup(void)
@@ -51,6 +56,7 @@ void map_aqueduct_backup(void)
 void map_aqueduct_restore(void)
 {
     map_grid_copy_u8(aqueduct_backup.items, aqueduct.items);
+    map_water_supply_invalidate_all();
 }
 
 void map_aqueduct_save_state(buffer *buf, buffer *backup)
@@ -62,5 +68,6 @@ void map_aqueduct_save_state(buffer *buf, buffer *backup)
 void map_aqueduct_load_state(buffer *buf, buffer *backup)
 {
     map_grid_load_state_u8(aqueduct.items, buf);
+    map_water_supply_invalidate_all();
     map_grid_load_state_u8(aqueduct_backup.items, backup);
 }
@@ -3,10 +3,19 @@
 #include "building/building.h"
 #include "map/grid.h"
 
+#include <string.h>
+
+#define NEARBY_RADIUS 2
+#define NEARBY_SIZE (2 * NEARBY_RADIUS + 1)
+#define NEARBY_KNOWN 0x80000000u
+
 static grid_u16 buildings_grid;
 static grid_u8 damage_grid;
 static grid_u8 rubble_type_grid;
 
+// Per tile, which tiles within NEARBY_RADIUS hold a building, row by row
+static uint32_t nearby_tiles[GRID_SIZE * GRID_SIZE];
+
 int map_building_at(int grid_offset)
 {
     if (grid_offset < 0 || grid_offset >= GRID_SIZE * GRID_SIZE) {
@@ -15,11 +24,59 @@ int map_building_at(int grid_offset)
     return buildings_grid.items[grid_offset];
 }
 
+static void invalidate_nearby(int grid_offset)
+{
+    for (int dy = -NEARBY_RADIUS; dy <= NEARBY_RADIUS; dy++) {
+        for (int dx = -NEARBY_RADIUS; dx <= NEARBY_RADIUS; dx++) {
+            int offset = grid_offset + dy * GRID_SIZE + dx;
+            if (offset >= 0 && offset < GRID_SIZE * GRID_SIZE) {
+                nearby_tiles[offset] = 0;
+            }
+        }
+    }
+}
+
 void map_building_set(int grid_offset, int building_id)
 {
+    if (!buildings_grid.items[grid_offset] != !building_id) {
+        invalidate_nearby(grid_offset);
+    }
     buildings_grid.items[grid_offset] = building_id;
 }
 
+static uint32_t find_nearby_tiles(int x, int y)
+{
+    uint32_t tiles = NEARBY_KNOWN;
+    int x_min, y_min, x_max, y_max;
+    map_grid_get_area(x, y, 1, NEARBY_RADIUS, &x_min, &y_min, &x_max, &y_max);
+    for (int yy = y_min; yy <= y_max; yy++) {
+        for (int xx = x_min; xx <= x_max; xx++) {
+            if (buildings_grid.items[map_grid_offset(xx, yy)]) {
+                tiles |= 1u << ((yy - y + NEARBY_RADIUS) * NEARBY_SIZE + xx - x + NEARBY_RADIUS);
+            }
+        }
+    }
+    return tiles;
+}
+
+int map_building_list_nearby(int x, int y, int *building_ids)
+{
+    int grid_offset = map_grid_offset(x, y);
+    uint32_t tiles = nearby_tiles[grid_offset];
+    if (!tiles) {
+        tiles = find_nearby_tiles(x, y);
+        nearby_tiles[grid_offset] = tiles;
+    }
+    int count = 0;
+    int corner_offset = grid_offset - NEARBY_RADIUS * GRID_SIZE - NEARBY_RADIUS;
+    for (int i = 0; i < NEARBY_SIZE * NEARBY_SIZE; i++) {
+        if (tiles & (1u << i)) {
+            building_ids[count++] = buildings_grid.items[corner_offset + (i / NEARBY_SIZE) * GRID_SIZE + i % NEARBY_SIZE];
+        }
+    }
+    return count;
+}
+
 void map_building_damage_clear(int grid_offset)
 {
     damage_grid.items[grid_offset] = 0;
@@ -45,6 +102,7 @@ void map_building_clear(void)
     map_grid_clear_u16(buildings_grid.items);
     map_grid_clear_u8(damage_grid.items);
     map_grid_clear_u8(rubble_type_grid.items);
+    memset(nearby_tiles, 0, sizeof(nearby_tiles));
 }
 
 void map_building_save_state(buffer *buildings, buffer *damage)
@@ -57,6 +115,7 @@ void map_building_load_state(buffer *buildings, buffer *damage)
 {
     map_grid_load_state_u16(buildings_grid.items, buildings);
     map_grid_load_state_u8(damage_grid.items, damage);
+    memset(nearby_tiles, 0, sizeof(nearby_tiles));
 }
 
 int map_building_is_reservoir(int x, int y)
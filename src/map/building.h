@@ -4,6 +4,8 @@
 #include "building/type.h"
 #include "core/buffer.h"
 
+#define MAP_BUILDING_MAX_NEARBY 25
+
 /**
  * Returns the building at the given offset
  * @param grid_offset Map offset
@@ -13,6 +15,16 @@ int map_building_at(int grid_offset);
 
 void map_building_set(int grid_offset, int building_id);
 
+/**
+ * Lists the buildings within two tiles of the given tile, in map order.
+ * A building is listed once for every one of its tiles in range.
+ * @param x X coordinate
+ * @param y Y coordinate
+ * @param building_ids Array of at least MAP_BUILDING_MAX_NEARBY items to fill
+ * @return Number of items in the list
+ */
+int map_building_list_nearby(int x, int y, int *building_ids);
+
 /**
  * Increases building damage by 1
  * @param grid_offset Map offset
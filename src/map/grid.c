@@ -202,9 +202,7 @@ void map_grid_save_state_i8(const int8_t *grid, buffer *buf)
 
 void map_grid_save_state_u16(const uint16_t *grid, buffer *buf)
 {
-    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-        buffer_write_u16(buf, grid[i]);
-    }
+    buffer_write_u16_array(buf, grid, GRID_SIZE * GRID_SIZE);
 }
 
 void map_grid_load_state_u8(uint8_t *grid, buffer *buf)
@@ -219,7 +217,5 @@ void map_grid_load_state_i8(int8_t *grid, buffer *buf)
 
 void map_grid_load_state_u16(uint16_t *grid, buffer *buf)
 {
-    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-        grid[i] = buffer_read_u16(buf);
-    }
+    buffer_read_u16_array(buf, grid, GRID_SIZE * GRID_SIZE);
 }
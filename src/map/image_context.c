@@ -9,6 +9,7 @@
 #include "map/terrain.h"
 
 #define MAX_TILES 8
+#define NO_MATCH 0xff
 
 struct terrain_image_context {
     const unsigned char tiles[MAX_TILES];
@@ -328,29 +329,48 @@ static int context_matches_tiles(const struct terrain_image_context *context, co
     return 1;
 }
 
-static const terrain_image *get_image(int group, int tiles[MAX_TILES])
+static terrain_image result;
+
+static const terrain_image *use_context(int group, int index)
 {
-    static terrain_image result;
+    struct terrain_image_context *context = &context_pointers[group].context[index];
+    context->current_item_offset++;
+    if (context->current_item_offset >= context->max_item_offset) {
+        context->current_item_offset = 0;
+    }
+    result.is_valid = 1;
+    result.group_offset = context->offset_for_orientation[city_view_orientation() / 2];
+    result.item_offset = context->current_item_offset;
+    result.aqueduct_offset = context->aqueduct_offset;
+    result.context_id = (group << 8) | index;
+    return &result;
+}
 
-    result.is_valid = 0;
+static const terrain_image *get_image(int group, int tiles[MAX_TILES])
+{
     struct terrain_image_context *context = context_pointers[group].context;
     int size = context_pointers[group].size;
     for (int i = 0; i < size; i++) {
         if (context_matches_tiles(&context[i], tiles)) {
-            context[i].current_item_offset++;
-            if (context[i].current_item_offset >= context[i].max_item_offset) {
-                context[i].current_item_offset = 0;
-            }
-            result.is_valid = 1;
-            result.group_offset = context[i].offset_for_orientation[city_view_orientation() / 2];
-            result.item_offset = context[i].current_item_offset;
-            result.aqueduct_offset = context[i].aqueduct_offset;
-            break;
+            return use_context(group, i);
         }
     }
+    result.is_valid = 0;
+    result.context_id = (group << 8) | NO_MATCH;
     return &result;
 }
 
+const terrain_image *map_image_context_get_by_id(int context_id)
+{
+    int index = context_id & 0xff;
+    if (index == NO_MATCH) {
+        result.is_valid = 0;
+        result.context_id = context_id;
+        return &result;
+    }
+    return use_context(context_id >> 8, index);
+}
+
 const terrain_image *map_image_context_get_elevation(int grid_offset, int elevation)
 {
     int tiles[MAX_TILES];
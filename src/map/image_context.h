@@ -6,6 +6,7 @@ typedef struct {
     int group_offset;
     int item_offset;
     int aqueduct_offset;
+    int context_id;
 } terrain_image;
 
 void map_image_context_init(void);
@@ -21,4 +22,12 @@ const terrain_image *map_image_context_get_dirt_road(int grid_offset);
 const terrain_image *map_image_context_get_paved_road(int grid_offset);
 const terrain_image *map_image_context_get_aqueduct(int grid_offset, int include_construction);
 
+/**
+ * Returns the image for a context found by an earlier lookup, without checking the surrounding tiles.
+ * The image variation advances the same way as it does for a full lookup.
+ * @param context_id Context id of an earlier lookup result
+ * @return Terrain image
+ */
+const terrain_image *map_image_context_get_by_id(int context_id);
+
 #endif // MAP_IMAGE_CONTEXT_H
@@ -1,17 +1,28 @@
 #include "road_network.h"
 
 #include "city/map.h"
+#include "core/log.h"
 #include "map/data.h"
 #include "map/grid.h"
 #include "map/routing_terrain.h"
 #include "map/terrain.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #define MAX_QUEUE 1000
+#define MAX_COMPONENTS (GRID_SIZE * GRID_SIZE / 2 + 1)
+#define MAX_CHANGED_TILES 500
+#define MAX_NETWORK_ID 255
 
 static const int ADJACENT_OFFSETS[] = {-162, 1, 162, -1};
 
+enum {
+    TILE_NONE = 0,
+    TILE_CONNECTED = 1,
+    TILE_ROAD = 2
+};
+
 static grid_u8 network;
 
 static struct {
@@ -20,9 +31,44 @@ static struct {
     int tail;
 } queue;
 
+/**
+ * Road network index: connected components of tiles that road networks
+ * spread over, kept up to date from the tiles that changed since the last
+ * update. Each component keeps a linked list of its tiles through next_tile.
+ */
+static struct {
+    grid_u8 tile_type;
+    grid_u16 id;
+    grid_u16 next_tile;
+    struct {
+        int first_tile;
+        int first_road;
+        int size;
+        int network_id;
+    } items[MAX_COMPONENTS];
+    int next_id;
+    int first_new_id;
+    int ordered[MAX_COMPONENTS];
+} components;
+
+static struct {
+    int needs_update;
+    int all;
+    int count;
+    int offsets[MAX_CHANGED_TILES];
+} changes = {1, 1, 0};
+
 void map_road_network_clear(void)
 {
     map_grid_clear_u8(network.items);
+    map_grid_clear_u8(components.tile_type.items);
+    changes.needs_update = 1;
+    changes.all = 1;
+}
+
+void map_road_network_invalidate(void)
+{
+    changes.needs_update = 1;
 }
 
 int map_road_network_get(int grid_offset)
@@ -73,7 +119,7 @@ static int mark_road_network(int grid_offset, uint8_t network_id)
     return size;
 }
 
-void map_road_network_update(void)
+static void recalculate_all_road_networks(void)
 {
     city_map_clear_largest_road_networks();
     map_grid_clear_u8(network.items);
@@ -89,3 +135,212 @@ void map_road_network_update(void)
         }
     }
 }
+
+static int get_tile_type(int grid_offset)
+{
+    if (map_routing_citizen_is_passable(grid_offset) &&
+        (map_routing_citizen_is_road(grid_offset) || map_terrain_is(grid_offset, TERRAIN_ACCESS_RAMP))) {
+        return map_terrain_is(grid_offset, TERRAIN_ROAD) ? TILE_ROAD : TILE_CONNECTED;
+    }
+    return TILE_NONE;
+}
+
+static int update_tile_types(void)
+{
+    changes.count = 0;
+    int grid_offset = map_data.start_offset;
+    for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
+        for (int x = 0; x < map_data.width; x++, grid_offset++) {
+            int type = get_tile_type(grid_offset);
+            if (type == TILE_NONE && map_terrain_is(grid_offset, TERRAIN_ROAD)) {
+                // road the routing grid does not know about yet: only the full recalculation handles this
+                return 0;
+            }
+            if (type != components.tile_type.items[grid_offset]) {
+                components.tile_type.items[grid_offset] = type;
+                if (changes.count < MAX_CHANGED_TILES) {
+                    changes.offsets[changes.count] = grid_offset;
+                }
+                changes.count++;
+            }
+        }
+    }
+    return 1;
+}
+
+static int label_component(int grid_offset)
+{
+    if (components.next_id >= MAX_COMPONENTS) {
+        return 0;
+    }
+    int id = components.next_id++;
+    components.items[components.id.items[grid_offset]].first_tile = 0;
+    components.items[id].first_tile = grid_offset;
+    components.items[id].first_road = 0;
+    components.items[id].size = 0;
+    components.items[id].network_id = -1;
+    components.id.items[grid_offset] = id;
+    components.next_tile.items[grid_offset] = 0;
+    int last_tile = grid_offset;
+    // the tile list doubles as the flood fill queue
+    for (int offset = grid_offset; offset; offset = components.next_tile.items[offset]) {
+        components.items[id].size++;
+        if (components.tile_type.items[offset] == TILE_ROAD &&
+            (!components.items[id].first_road || offset < components.items[id].first_road)) {
+            components.items[id].first_road = offset;
+        }
+        for (int i = 0; i < 4; i++) {
+            int new_offset = offset + ADJACENT_OFFSETS[i];
+            if (components.tile_type.items[new_offset] && components.id.items[new_offset] < components.first_new_id) {
+                components.items[components.id.items[new_offset]].first_tile = 0;
+                components.id.items[new_offset] = id;
+                components.next_tile.items[new_offset] = 0;
+                components.next_tile.items[last_tile] = new_offset;
+                last_tile = new_offset;
+            }
+        }
+    }
+    return 1;
+}
+
+static void label_all_components(void)
+{
+    map_grid_clear_u8(network.items);
+    map_grid_clear_u16(components.id.items);
+    components.next_id = 1;
+    components.first_new_id = 1;
+    int grid_offset = map_data.start_offset;
+    for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
+        for (int x = 0; x < map_data.width; x++, grid_offset++) {
+            if (components.tile_type.items[grid_offset] && !components.id.items[grid_offset]) {
+                label_component(grid_offset);
+            }
+        }
+    }
+}
+
+static int label_changed_components(void)
+{
+    components.first_new_id = components.next_id;
+    for (int i = 0; i < changes.count; i++) {
+        int grid_offset = changes.offsets[i];
+        if (!components.tile_type.items[grid_offset]) {
+            // removing a tile may split its component: relabel from the neighbours
+            components.items[components.id.items[grid_offset]].first_tile = 0;
+            components.id.items[grid_offset] = 0;
+            network.items[grid_offset] = 0;
+        } else if (components.id.items[grid_offset] < components.first_new_id) {
+            if (!label_component(grid_offset)) {
+                return 0;
+            }
+        }
+        for (int d = 0; d < 4; d++) {
+            int new_offset = grid_offset + ADJACENT_OFFSETS[d];
+            if (components.tile_type.items[new_offset] && components.id.items[new_offset] < components.first_new_id) {
+                if (!label_component(new_offset)) {
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+static void set_component_network(int id, int network_id)
+{
+    if (components.items[id].network_id == network_id) {
+        return;
+    }
+    for (int grid_offset = components.items[id].first_tile; grid_offset;
+        grid_offset = components.next_tile.items[grid_offset]) {
+        network.items[grid_offset] = network_id;
+    }
+    components.items[id].network_id = network_id;
+}
+
+static int compare_first_road(const void *va, const void *vb)
+{
+    return components.items[*(const int *) va].first_road - components.items[*(const int *) vb].first_road;
+}
+
+static int update_network_ids(void)
+{
+    // networks are numbered in map order of their first road tile, like the full recalculation does
+    int total = 0;
+    for (int id = 1; id < components.next_id; id++) {
+        if (components.items[id].first_tile) {
+            if (components.items[id].first_road) {
+                components.ordered[total++] = id;
+            } else {
+                set_component_network(id, 0);
+            }
+        }
+    }
+    if (total > MAX_NETWORK_ID) {
+        return 0;
+    }
+    qsort(components.ordered, total, sizeof(int), compare_first_road);
+    city_map_clear_largest_road_networks();
+    for (int i = 0; i < total; i++) {
+        int id = components.ordered[i];
+        set_component_network(id, i + 1);
+        city_map_add_to_largest_road_networks(i + 1, components.items[id].size);
+    }
+    return 1;
+}
+
+static int update_road_networks(void)
+{
+    if (!update_tile_types()) {
+        return 0;
+    }
+    if (changes.all || changes.count > MAX_CHANGED_TILES || !label_changed_components()) {
+        label_all_components();
+    }
+    components.items[0].first_tile = 0;
+    components.first_new_id = components.next_id;
+    return update_network_ids();
+}
+
+#ifdef VERIFY_ROAD_NETWORK
+static void verify_road_networks(void)
+{
+    static grid_u8 incremental;
+    int largest_index[MAX_NETWORK_ID + 1];
+    map_grid_copy_u8(network.items, incremental.items);
+    for (int id = 1; id <= MAX_NETWORK_ID; id++) {
+        largest_index[id] = city_map_road_network_index(id);
+    }
+    recalculate_all_road_networks();
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        if (incremental.items[i] != network.items[i]) {
+            log_error("Road network index differs from recalculation at offset", 0, i);
+            changes.all = 1;
+            break;
+        }
+    }
+    for (int id = 1; id <= MAX_NETWORK_ID; id++) {
+        if (largest_index[id] != city_map_road_network_index(id)) {
+            log_error("Largest road networks differ from recalculation for network", 0, id);
+            break;
+        }
+    }
+}
+#endif
+
+void map_road_network_update(void)
+{
+    if (!changes.needs_update) {
+        return;
+    }
+    if (update_road_networks()) {
+        changes.all = 0;
+    } else {
+        recalculate_all_road_networks();
+        changes.all = 1;
+    }
+    changes.needs_update = 0;
+#ifdef VERIFY_ROAD_NETWORK
+    verify_road_networks();
+#endif
+}
@@ -3,8 +3,20 @@
 
 void map_road_network_clear(void);
 
+/**
+ * Marks the road networks as possibly changed, to be checked on the next update
+ */
+void map_road_network_invalidate(void);
+
 int map_road_network_get(int grid_offset);
 
+/**
+ * Updates the road network ids from the road network index.
+ * Only the networks around changed tiles are relabelled. Network ids are
+ * numbered by the map position of each network's first road tile, so they
+ * only change when the road networks change.
+ * Build with VERIFY_ROAD_NETWORK to check the result against a full recalculation.
+ */
 void map_road_network_update(void);
 
 #endif // MAP_ROAD_NETWORK_H
@@ -9,6 +9,7 @@
 #include "map/image.h"
 #include "map/property.h"
 #include "map/random.h"
+#include "map/road_network.h"
 #include "map/routing_data.h"
 #include "map/sprite.h"
 #include "map/terrain.h"
@@ -137,6 +138,7 @@ void map_routing_update_land_citizen(void)
             }
         }
     }
+    map_road_network_invalidate();
 }
 
 static int get_land_type_noncitizen(int grid_offset)
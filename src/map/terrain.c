@@ -2,7 +2,13 @@
 
 #include "map/grid.h"
 #include "map/ring.h"
+#include "map/road_network.h"
 #include "map/routing.h"
+#include "map/tiles.h"
+#include "map/water_supply.h"
+
+// Terrain that road and water images are picked from
+#define TILE_IMAGE_TERRAIN (TERRAIN_ROAD | TERRAIN_WATER | TERRAIN_BUILDING | TERRAIN_GATEHOUSE | TERRAIN_AQUEDUCT)
 
 static grid_u16 terrain_grid;
 static grid_u16 terrain_grid_backup;
@@ -17,18 +23,41 @@ int map_terrain_get(int grid_offset)
     return terrain_grid.items[grid_offset];
 }
 
+static void terrain_changed(int grid_offset, int changed_terrain)
+{
+    if (changed_terrain & TERRAIN_AQUEDUCT) {
+        map_water_supply_invalidate_tile(grid_offset);
+    }
+    if (changed_terrain & (TERRAIN_ROAD | TERRAIN_ACCESS_RAMP)) {
+        map_road_network_invalidate();
+    }
+    if (changed_terrain & TILE_IMAGE_TERRAIN) {
+        map_tiles_terrain_changed(grid_offset);
+    }
+}
+
+static void all_terrain_changed(void)
+{
+    map_water_supply_invalidate_all();
+    map_road_network_invalidate();
+    map_tiles_all_terrain_changed();
+}
+
 void map_terrain_set(int grid_offset, int terrain)
 {
+    terrain_changed(grid_offset, terrain_grid.items[grid_offset] ^ terrain);
     terrain_grid.items[grid_offset] = terrain;
 }
 
 void map_terrain_add(int grid_offset, int terrain)
 {
+    terrain_changed(grid_offset, terrain & ~terrain_grid.items[grid_offset]);
     terrain_grid.items[grid_offset] |= terrain;
 }
 
 void map_terrain_remove(int grid_offset, int terrain)
 {
+    terrain_changed(grid_offset, terrain & terrain_grid.items[grid_offset]);
     terrain_grid.items[grid_offset] &= ~terrain;
 }
 
@@ -58,6 +87,9 @@ void map_terrain_remove_with_radius(int x, int y, int size, int radius, int terr
 
 void map_terrain_remove_all(int terrain)
 {
+    if (terrain & (TILE_IMAGE_TERRAIN | TERRAIN_ACCESS_RAMP)) {
+        all_terrain_changed();
+    }
     map_grid_and_u16(terrain_grid.items, ~terrain);
 }
 
@@ -327,11 +359,13 @@ void map_terrain_backup(void)
 void map_terrain_restore(void)
 {
     map_grid_copy_u16(terrain_grid_backup.items, terrain_grid.items);
+    all_terrain_changed();
 }
 
 void map_terrain_clear(void)
 {
     map_grid_clear_u16(terrain_grid.items);
+    all_terrain_changed();
 }
 
 void map_terrain_init_outside_map(void)
@@ -358,4 +392,5 @@ void map_terrain_save_state(buffer *buf)
 void map_terrain_load_state(buffer *buf)
 {
     map_grid_load_state_u16(terrain_grid.items, buf);
+    all_terrain_changed();
 }
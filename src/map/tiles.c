@@ -27,6 +27,11 @@
 
 static int aqueduct_include_construction = 0;
 
+static struct {
+    grid_u16 context; // context id + 1 of the last road or water image lookup, 0 = not known
+    grid_u8 variant; // paved road or fortified shore for that lookup
+} image_cache;
+
 static int is_clear(int x, int y, int size, int disallowed_terrain, int check_image)
 {
     if (!map_grid_is_inside(x, y, size)) {
@@ -660,6 +665,41 @@ int map_tiles_is_paved_road(int grid_offset)
     return 0;
 }
 
+static void cache_image_context(int grid_offset, const terrain_image *img, int variant)
+{
+    image_cache.context.items[grid_offset] = img->context_id + 1;
+    image_cache.variant.items[grid_offset] = variant;
+}
+
+void map_tiles_terrain_changed(int grid_offset)
+{
+    // road images look at the direct neighbours, water images at buildings up to two tiles away
+    for (int dy = -2; dy <= 2; dy++) {
+        for (int dx = -2; dx <= 2; dx++) {
+            int offset = grid_offset + dy * GRID_SIZE + dx;
+            if (offset >= 0 && offset < GRID_SIZE * GRID_SIZE) {
+                image_cache.context.items[offset] = 0;
+            }
+        }
+    }
+}
+
+void map_tiles_all_terrain_changed(void)
+{
+    map_grid_clear_u16(image_cache.context.items);
+}
+
+static const terrain_image *get_road_image_context(int grid_offset, int paved)
+{
+    if (image_cache.context.items[grid_offset] && image_cache.variant.items[grid_offset] == paved) {
+        return map_image_context_get_by_id(image_cache.context.items[grid_offset] - 1);
+    }
+    const terrain_image *img = paved ?
+        map_image_context_get_paved_road(grid_offset) : map_image_context_get_dirt_road(grid_offset);
+    cache_image_context(grid_offset, img, paved);
+    return img;
+}
+
 static void set_road_with_aqueduct_image(int grid_offset)
 {
     int image_aqueduct = image_group(GROUP_BUILDING_AQUEDUCT);
@@ -669,7 +709,13 @@ static void set_road_with_aqueduct_image(int grid_offset)
     } else {
         water_offset = 15;
     }
-    const terrain_image *img = map_image_context_get_aqueduct(grid_offset, 0);
+    const terrain_image *img;
+    if (image_cache.context.items[grid_offset]) {
+        img = map_image_context_get_by_id(image_cache.context.items[grid_offset] - 1);
+    } else {
+        img = map_image_context_get_aqueduct(grid_offset, 0);
+        cache_image_context(grid_offset, img, 0);
+    }
     int group_offset = img->group_offset;
     if (!img->aqueduct_offset) {
         if (map_terrain_is(grid_offset + map_grid_delta(0, -1), TERRAIN_ROAD)) {
@@ -701,11 +747,11 @@ static void set_road_image(int x, int y, int grid_offset)
         return;
     }
     if (map_tiles_is_paved_road(grid_offset)) {
-        const terrain_image *img = map_image_context_get_paved_road(grid_offset);
+        const terrain_image *img = get_road_image_context(grid_offset, 1);
         map_image_set(grid_offset, image_group(GROUP_TERRAIN_ROAD) +
                       img->group_offset + img->item_offset);
     } else {
-        const terrain_image *img = map_image_context_get_dirt_road(grid_offset);
+        const terrain_image *img = get_road_image_context(grid_offset, 0);
         map_image_set(grid_offset, image_group(GROUP_TERRAIN_ROAD) +
                       img->group_offset + img->item_offset + 49);
     }
@@ -853,9 +899,18 @@ void map_tiles_update_region_meadow(int x_min, int y_min, int x_max, int y_max)
 static void set_water_image(int x, int y, int grid_offset)
 {
     if ((map_terrain_get(grid_offset) & (TERRAIN_WATER | TERRAIN_BUILDING)) == TERRAIN_WATER) {
-        const terrain_image *img = map_image_context_get_shore(grid_offset);
+        const terrain_image *img;
+        int fortified;
+        if (image_cache.context.items[grid_offset]) {
+            img = map_image_context_get_by_id(image_cache.context.items[grid_offset] - 1);
+            fortified = image_cache.variant.items[grid_offset];
+        } else {
+            img = map_image_context_get_shore(grid_offset);
+            fortified = map_terrain_exists_tile_in_radius_with_type(x, y, 1, 2, TERRAIN_BUILDING);
+            cache_image_context(grid_offset, img, fortified);
+        }
         int image_id = image_group(GROUP_TERRAIN_WATER) + img->group_offset + img->item_offset;
-        if (map_terrain_exists_tile_in_radius_with_type(x, y, 1, 2, TERRAIN_BUILDING)) {
+        if (fortified) {
             // fortified shore
             int base = image_group(GROUP_TERRAIN_WATER_SHORE);
             switch (img->group_offset) {
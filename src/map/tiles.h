@@ -15,6 +15,17 @@ void map_tiles_update_all_walls(void);
 void map_tiles_update_area_walls(int x, int y, int size);
 int map_tiles_set_wall(int x, int y);
 
+/**
+ * Forgets the cached road and water image contexts around a tile whose terrain changed
+ * @param grid_offset Changed tile
+ */
+void map_tiles_terrain_changed(int grid_offset);
+
+/**
+ * Forgets all cached road and water image contexts
+ */
+void map_tiles_all_terrain_changed(void);
+
 int map_tiles_is_paved_road(int grid_offset);
 void map_tiles_update_all_roads(void);
 void map_tiles_update_area_roads(int x, int y, int size);
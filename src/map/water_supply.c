@@ -10,21 +10,45 @@
 #include "map/building.h"
 #include "map/grid.h"
 #include "map/image.h"
-#include "map/property.h"
 #include "map/terrain.h"
 #include "scenario/property.h"
 
 #include <string.h>
 
-#define MAX_QUEUE 1000
+#define MAX_NETWORKS (GRID_SIZE * GRID_SIZE / 2 + 1)
+#define MAX_CHANGED_TILES 500
 
 static const int ADJACENT_OFFSETS[] = {-GRID_SIZE, 1, GRID_SIZE, -1};
 
+// Aqueduct tiles next to the middle of each side of a reservoir
+static const int CONNECTOR_OFFSETS[] = {-161, 165, 487, 161};
+
+/**
+ * Aqueduct networks: 4-connected components of aqueduct tiles.
+ * Each network keeps its tiles in a linked list through next_tile so its
+ * water state can be rewritten without scanning the map.
+ */
+static struct {
+    grid_u16 id;
+    grid_u16 next_tile;
+    struct {
+        int first_tile;
+        int has_water;
+        int water_pass;
+    } items[MAX_NETWORKS];
+    int next_id;
+    int first_new_id;
+    int water_pass;
+    int wet[MAX_NETWORKS];
+    int num_wet;
+    int old_wet[MAX_NETWORKS];
+} networks;
+
 static struct {
-    int items[MAX_QUEUE];
-    int head;
-    int tail;
-} queue;
+    int all;
+    int count;
+    int offsets[MAX_CHANGED_TILES];
+} changes = {1, 0};
 
 static void mark_well_access(int well_id, int radius)
 {
@@ -68,102 +92,155 @@ void map_water_supply_update_houses(void)
     }
 }
 
-static void set_all_aqueducts_to_no_water(void)
+void map_water_supply_invalidate_tile(int grid_offset)
 {
-    int image_without_water = image_group(GROUP_BUILDING_AQUEDUCT) + 15;
+    if (changes.all) {
+        return;
+    }
+    if (changes.count >= MAX_CHANGED_TILES) {
+        changes.all = 1;
+        return;
+    }
+    changes.offsets[changes.count++] = grid_offset;
+}
+
+void map_water_supply_invalidate_all(void)
+{
+    changes.all = 1;
+}
+
+static int label_network(int grid_offset)
+{
+    if (networks.next_id >= MAX_NETWORKS) {
+        return 0;
+    }
+    int id = networks.next_id++;
+    networks.items[id].first_tile = grid_offset;
+    networks.items[id].has_water = 0;
+    networks.items[id].water_pass = 0;
+    networks.items[networks.id.items[grid_offset]].first_tile = 0;
+    networks.id.items[grid_offset] = id;
+    networks.next_tile.items[grid_offset] = 0;
+    int last_tile = grid_offset;
+    // the tile list doubles as the flood fill queue
+    for (int offset = grid_offset; offset; offset = networks.next_tile.items[offset]) {
+        for (int i = 0; i < 4; i++) {
+            int new_offset = offset + ADJACENT_OFFSETS[i];
+            if (map_terrain_is(new_offset, TERRAIN_AQUEDUCT) &&
+                networks.id.items[new_offset] < networks.first_new_id) {
+                // the old network this tile belonged to is superseded
+                networks.items[networks.id.items[new_offset]].first_tile = 0;
+                networks.id.items[new_offset] = id;
+                networks.next_tile.items[new_offset] = 0;
+                networks.next_tile.items[last_tile] = new_offset;
+                last_tile = new_offset;
+            }
+        }
+    }
+    return 1;
+}
+
+static void label_all_networks(void)
+{
+    map_grid_clear_u16(networks.id.items);
+    networks.next_id = 1;
+    networks.first_new_id = 1;
+    networks.num_wet = 0;
     int grid_offset = map_data.start_offset;
     for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
         for (int x = 0; x < map_data.width; x++, grid_offset++) {
-            if (map_terrain_is(grid_offset, TERRAIN_AQUEDUCT)) {
-                map_aqueduct_set(grid_offset, 0);
-                int image_id = map_image_at(grid_offset);
-                if (image_id < image_without_water) {
-                    map_image_set(grid_offset, image_id + 15);
-                }
+            if (map_terrain_is(grid_offset, TERRAIN_AQUEDUCT) && !networks.id.items[grid_offset]) {
+                label_network(grid_offset);
             }
         }
     }
 }
 
-static void fill_aqueducts_from_offset(int grid_offset)
+static int label_changed_networks(void)
 {
-    if (!map_terrain_is(grid_offset, TERRAIN_AQUEDUCT)) {
-        return;
-    }
-    memset(&queue, 0, sizeof(queue));
-    int guard = 0;
-    int next_offset;
-    int image_without_water = image_group(GROUP_BUILDING_AQUEDUCT) + 15;
-    do {
-        if (++guard >= GRID_SIZE * GRID_SIZE) {
-            break;
-        }
-        map_aqueduct_set(grid_offset, 1);
-        int image_id = map_image_at(grid_offset);
-        if (image_id >= image_without_water) {
-            map_image_set(grid_offset, image_id - 15);
+    networks.first_new_id = networks.next_id;
+    for (int i = 0; i < changes.count; i++) {
+        int grid_offset = changes.offsets[i];
+        if (!map_terrain_is(grid_offset, TERRAIN_AQUEDUCT)) {
+            // removing a tile may split its network: relabel from the neighbours
+            networks.items[networks.id.items[grid_offset]].first_tile = 0;
+            networks.id.items[grid_offset] = 0;
+        } else if (networks.id.items[grid_offset] < networks.first_new_id) {
+            if (!label_network(grid_offset)) {
+                return 0;
+            }
         }
-        next_offset = -1;
-        for (int i = 0; i < 4; i++) {
-            int new_offset = grid_offset + ADJACENT_OFFSETS[i];
-            building *b = building_get(map_building_at(new_offset));
-            if (b->id && b->type == BUILDING_RESERVOIR) {
-                // check if aqueduct connects to reservoir --> doesn't connect to corner
-                int xy = map_property_multi_tile_xy(new_offset);
-                if (xy != EDGE_X0Y0 && xy != EDGE_X2Y0 && xy != EDGE_X0Y2 && xy != EDGE_X2Y2) {
-                    if (!b->has_water_access) {
-                        b->has_water_access = 2;
-                    }
-                }
-            } else if (map_terrain_is(new_offset, TERRAIN_AQUEDUCT)) {
-                if (!map_aqueduct_at(new_offset)) {
-                    if (next_offset == -1) {
-                        next_offset = new_offset;
-                    } else {
-                        queue.items[queue.tail++] = new_offset;
-                        if (queue.tail >= MAX_QUEUE) {
-                            queue.tail = 0;
-                        }
-                    }
+        for (int d = 0; d < 4; d++) {
+            int new_offset = grid_offset + ADJACENT_OFFSETS[d];
+            if (map_terrain_is(new_offset, TERRAIN_AQUEDUCT) &&
+                networks.id.items[new_offset] < networks.first_new_id) {
+                if (!label_network(new_offset)) {
+                    return 0;
                 }
             }
         }
-        if (next_offset == -1) {
-            if (queue.head == queue.tail) {
-                return;
-            }
-            next_offset = queue.items[queue.head++];
-            if (queue.head >= MAX_QUEUE) {
-                queue.head = 0;
+    }
+    return 1;
+}
+
+static void update_networks(void)
+{
+    if (changes.all || !label_changed_networks()) {
+        label_all_networks();
+    }
+    networks.items[0].first_tile = 0;
+}
+
+static void set_network_water(int id, int has_water)
+{
+    int image_without_water = image_group(GROUP_BUILDING_AQUEDUCT) + 15;
+    for (int grid_offset = networks.items[id].first_tile; grid_offset;
+        grid_offset = networks.next_tile.items[grid_offset]) {
+        map_aqueduct_set(grid_offset, has_water);
+        int image_id = map_image_at(grid_offset);
+        if (has_water) {
+            if (image_id >= image_without_water) {
+                map_image_set(grid_offset, image_id - 15);
             }
+        } else if (image_id < image_without_water) {
+            map_image_set(grid_offset, image_id + 15);
         }
-        grid_offset = next_offset;
-    } while (next_offset > -1);
+    }
+    networks.items[id].has_water = has_water;
 }
 
-void map_water_supply_update_reservoir_fountain(void)
+static void fill_network_from_offset(int grid_offset)
 {
-    map_terrain_remove_all(TERRAIN_FOUNTAIN_RANGE | TERRAIN_RESERVOIR_RANGE);
-    // reservoirs
-    set_all_aqueducts_to_no_water();
-    building_list_large_clear(1);
-    // mark reservoirs next to water
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_RESERVOIR) {
-            building_list_large_add(i);
-            if (map_terrain_exists_tile_in_area_with_type(b->x - 1, b->y - 1, 5, TERRAIN_WATER)) {
-                b->has_water_access = 2;
-            } else {
-                b->has_water_access = 0;
+    int id = networks.id.items[grid_offset];
+    if (id && networks.items[id].water_pass != networks.water_pass) {
+        networks.items[id].water_pass = networks.water_pass;
+        networks.wet[networks.num_wet++] = id;
+    }
+}
+
+static int reservoir_connects_to_water(building *b)
+{
+    for (int d = 0; d < 4; d++) {
+        int id = networks.id.items[b->grid_offset + CONNECTOR_OFFSETS[d]];
+        if (id && networks.items[id].water_pass == networks.water_pass) {
+            // the reservoir tile next to the aqueduct must belong to this reservoir
+            if (map_building_at(b->grid_offset + CONNECTOR_OFFSETS[d] - ADJACENT_OFFSETS[d]) == b->id) {
+                return 1;
             }
         }
     }
-    int total_reservoirs = building_list_large_size();
-    const int *reservoirs = building_list_large_items();
+    return 0;
+}
+
+static void update_aqueduct_water(int total_reservoirs, const int *reservoirs)
+{
+    int old_num_wet = networks.num_wet;
+    memcpy(networks.old_wet, networks.wet, old_num_wet * sizeof(int));
+    networks.num_wet = 0;
+    networks.water_pass++;
+
     // fill reservoirs from full ones
     int changed = 1;
-    static const int CONNECTOR_OFFSETS[] = {-161, 165, 487, 161};
     while (changed == 1) {
         changed = 0;
         for (int i = 0; i < total_reservoirs; i++) {
@@ -172,8 +249,73 @@ void map_water_supply_update_reservoir_fountain(void)
                 b->has_water_access = 1;
                 changed = 1;
                 for (int d = 0; d < 4; d++) {
-                    fill_aqueducts_from_offset(b->grid_offset + CONNECTOR_OFFSETS[d]);
+                    fill_network_from_offset(b->grid_offset + CONNECTOR_OFFSETS[d]);
                 }
+            } else if (!b->has_water_access && reservoir_connects_to_water(b)) {
+                b->has_water_access = 2;
+                changed = 1;
+            }
+        }
+    }
+    // only rewrite tiles of networks that are new or changed water state
+    for (int i = 0; i < old_num_wet; i++) {
+        int id = networks.old_wet[i];
+        if (networks.items[id].first_tile && networks.items[id].water_pass != networks.water_pass) {
+            set_network_water(id, 0);
+        }
+    }
+    for (int i = 0; i < networks.num_wet; i++) {
+        int id = networks.wet[i];
+        if (!networks.items[id].has_water || id >= networks.first_new_id) {
+            set_network_water(id, 1);
+        }
+    }
+    for (int id = networks.first_new_id; id < networks.next_id; id++) {
+        if (networks.items[id].first_tile && networks.items[id].water_pass != networks.water_pass) {
+            set_network_water(id, 0);
+        }
+    }
+    networks.first_new_id = networks.next_id;
+    // our own tile updates do not count as changes
+    changes.all = 0;
+    changes.count = 0;
+}
+
+void map_water_supply_update_reservoir_fountain(void)
+{
+    map_terrain_remove_all(TERRAIN_FOUNTAIN_RANGE | TERRAIN_RESERVOIR_RANGE);
+    update_networks();
+    // reservoirs
+    building_list_large_clear(1);
+    int other_reservoirs = 0;
+    // mark reservoirs next to water
+    for (int i = 1; i < MAX_BUILDINGS; i++) {
+        building *b = building_get(i);
+        if (b->type != BUILDING_RESERVOIR || b->state == BUILDING_STATE_UNUSED) {
+            continue;
+        }
+        if (b->state != BUILDING_STATE_IN_USE) {
+            other_reservoirs++;
+            continue;
+        }
+        building_list_large_add(i);
+        if (map_terrain_exists_tile_in_area_with_type(b->x - 1, b->y - 1, 5, TERRAIN_WATER)) {
+            b->has_water_access = 2;
+        } else {
+            b->has_water_access = 0;
+        }
+    }
+    int total_reservoirs = building_list_large_size();
+    const int *reservoirs = building_list_large_items();
+    update_aqueduct_water(total_reservoirs, reservoirs);
+    // reservoirs that are not in use still receive water from adjacent aqueducts
+    for (int i = 1; i < MAX_BUILDINGS && other_reservoirs > 0; i++) {
+        building *b = building_get(i);
+        if (b->type == BUILDING_RESERVOIR && b->state != BUILDING_STATE_UNUSED &&
+            b->state != BUILDING_STATE_IN_USE) {
+            other_reservoirs--;
+            if (!b->has_water_access && reservoir_connects_to_water(b)) {
+                b->has_water_access = 2;
             }
         }
     }
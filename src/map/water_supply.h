@@ -4,6 +4,18 @@
 void map_water_supply_update_houses(void);
 void map_water_supply_update_reservoir_fountain(void);
 
+/**
+ * Marks an aqueduct tile as changed so that its network is recalculated
+ * on the next reservoir update
+ * @param grid_offset Offset of the changed tile
+ */
+void map_water_supply_invalidate_tile(int grid_offset);
+
+/**
+ * Marks all aqueduct networks as changed, for when the map is replaced as a whole
+ */
+void map_water_supply_invalidate_all(void);
+
 enum {
     WELL_NECESSARY = 0,
     WELL_UNNECESSARY_FOUNTAIN = 1,
@@ -171,6 +171,26 @@ FILE *platform_file_manager_open_file(const char *filename, const char *mode)
     return fp;
 }
 
+int platform_file_manager_rename_file(const char *filename, const char *new_filename)
+{
+    char *resolved_path = vita_prepend_path(filename);
+    char *resolved_new_path = vita_prepend_path(new_filename);
+    remove(resolved_new_path);
+    int result = rename(resolved_path, resolved_new_path) == 0;
+    free(resolved_path);
+    free(resolved_new_path);
+    return result;
+}
+
+int64_t platform_file_manager_get_modified_time(const char *filename)
+{
+    char *resolved_path = vita_prepend_path(filename);
+    struct stat file_info;
+    int64_t result = stat(resolved_path, &file_info) == 0 ? (int64_t) file_info.st_mtime : 0;
+    free(resolved_path);
+    return result;
+}
+
 #elif defined(_WIN32)
 
 FILE *platform_file_manager_open_file(const char *filename, const char *mode)
@@ -186,6 +206,28 @@ FILE *platform_file_manager_open_file(const char *filename, const char *mode)
     return fp;
 }
 
+int platform_file_manager_rename_file(const char *filename, const char *new_filename)
+{
+    wchar_t *wfile = utf8_to_wchar(filename);
+    wchar_t *wnew_file = utf8_to_wchar(new_filename);
+
+    int result = MoveFileExW(wfile, wnew_file, MOVEFILE_REPLACE_EXISTING) != 0;
+
+    free(wfile);
+    free(wnew_file);
+
+    return result;
+}
+
+int64_t platform_file_manager_get_modified_time(const char *filename)
+{
+    wchar_t *wfile = utf8_to_wchar(filename);
+    struct _stat64 file_info;
+    int64_t result = _wstat64(wfile, &file_info) == 0 ? (int64_t) file_info.st_mtime : 0;
+    free(wfile);
+    return result;
+}
+
 #else
 
 FILE *platform_file_manager_open_file(const char *filename, const char *mode)
@@ -193,4 +235,15 @@ FILE *platform_file_manager_open_file(const char *filename, const char *mode)
     return fopen(filename, mode);
 }
 
+int platform_file_manager_rename_file(const char *filename, const char *new_filename)
+{
+    return rename(filename, new_filename) == 0;
+}
+
+int64_t platform_file_manager_get_modified_time(const char *filename)
+{
+    struct stat file_info;
+    return stat(filename, &file_info) == 0 ? (int64_t) file_info.st_mtime : 0;
+}
+
 #endif
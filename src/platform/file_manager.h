@@ -1,6 +1,7 @@
 #ifndef PLATFORM_FILE_MANAGER_H
 #define PLATFORM_FILE_MANAGER_H
 
+#include <stdint.h>
 #include <stdio.h>
 
 enum {
@@ -55,4 +56,19 @@ FILE *platform_file_manager_open_file(const char *filename, const char *mode);
  */
 int platform_file_manager_remove_file(const char *filename);
 
+/**
+ * Renames a file, replacing the destination if it exists
+ * @param filename The file to rename
+ * @param new_filename The new name of the file
+ * @return true if the file was renamed, false otherwise
+ */
+int platform_file_manager_rename_file(const char *filename, const char *new_filename);
+
+/**
+ * Gets the last modification time of a file
+ * @param filename The file to check
+ * @return Modification time in seconds since the epoch, 0 if the file does not exist
+ */
+int64_t platform_file_manager_get_modified_time(const char *filename);
+
 #endif // PLATFORM_FILE_MANAGER_H
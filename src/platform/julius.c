@@ -114,6 +114,125 @@ void system_exit(void)
     post_event(USER_EVENT_QUIT);
 }
 
+unsigned int system_get_ticks(void)
+{
+    return SDL_GetTicks();
+}
+
+typedef struct {
+    SDL_atomic_t running;
+    void (*task)(void *data);
+    void *data;
+} background_task;
+
+static background_task background_tasks[BACKGROUND_TASK_MAX];
+
+static int run_background_task(void *task_data)
+{
+    background_task *task = (background_task *) task_data;
+    task->task(task->data);
+    SDL_AtomicSet(&task->running, 0);
+    return 0;
+}
+
+int system_background_task_running(background_task_type type)
+{
+    return SDL_AtomicGet(&background_tasks[type].running);
+}
+
+int system_start_background_task(background_task_type type, void (*task)(void *data), void *data)
+{
+    background_task *current = &background_tasks[type];
+    if (SDL_AtomicGet(&current->running)) {
+        return 0;
+    }
+    current->task = task;
+    current->data = data;
+    SDL_AtomicSet(&current->running, 1);
+    SDL_Thread *thread = SDL_CreateThread(run_background_task, "background task", current);
+    if (!thread) {
+        SDL_Log("Unable to create background thread: %s", SDL_GetError());
+        SDL_AtomicSet(&current->running, 0);
+        return 0;
+    }
+    SDL_DetachThread(thread);
+    return 1;
+}
+
+void system_wait_for_background_task(background_task_type type)
+{
+    while (SDL_AtomicGet(&background_tasks[type].running)) {
+        SDL_Delay(1);
+    }
+}
+
+#define MAX_PARALLEL_WORKERS 16
+
+typedef struct {
+    void (*task)(int item, int worker, void *data);
+    void *data;
+    int num_items;
+    SDL_atomic_t next_item;
+} parallel_tasks;
+
+typedef struct {
+    parallel_tasks *tasks;
+    int index;
+} parallel_worker;
+
+static int run_parallel_worker(void *data)
+{
+    parallel_worker *worker = (parallel_worker *) data;
+    parallel_tasks *tasks = worker->tasks;
+    int item;
+    while ((item = SDL_AtomicAdd(&tasks->next_item, 1)) < tasks->num_items) {
+        tasks->task(item, worker->index, tasks->data);
+    }
+    return 0;
+}
+
+int system_run_parallel_tasks(void (*task)(int item, int worker, void *data), int num_items, int max_workers, void *data)
+{
+    int num_workers = SDL_GetCPUCount();
+    if (num_workers > max_workers) {
+        num_workers = max_workers;
+    }
+    if (num_workers > num_items) {
+        num_workers = num_items;
+    }
+    if (num_workers > MAX_PARALLEL_WORKERS) {
+        num_workers = MAX_PARALLEL_WORKERS;
+    }
+    if (num_workers < 2) {
+        return 0;
+    }
+    parallel_tasks tasks;
+    tasks.task = task;
+    tasks.data = data;
+    tasks.num_items = num_items;
+    SDL_AtomicSet(&tasks.next_item, 0);
+
+    parallel_worker workers[MAX_PARALLEL_WORKERS];
+    SDL_Thread *threads[MAX_PARALLEL_WORKERS];
+    int num_threads = 0;
+    for (int i = 1; i < num_workers; i++) {
+        workers[i].tasks = &tasks;
+        workers[i].index = i;
+        threads[num_threads] = SDL_CreateThread(run_parallel_worker, "worker", &workers[i]);
+        if (!threads[num_threads]) {
+            break;
+        }
+        num_threads++;
+    }
+    workers[0].tasks = &tasks;
+    workers[0].index = 0;
+    run_parallel_worker(&workers[0]);
+    for (int i = 0; i < num_threads; i++) {
+        SDL_WaitThread(threads[i], 0);
+    }
+    return num_threads + 1;
+}
+
 void system_resize(int width, int height)
 {
     static int s_width;
@@ -2,6 +2,7 @@
 #include "core/log.h"
 #include "sound/device.h"
 #include "game/settings.h"
+#include "game/system.h"
 #include "SDL.h"
 #include "SDL_mixer.h"
 #include "platform/vita/vita.h"
@@ -15,20 +16,60 @@
 #define AUDIO_BUFFERS 1024
 
 #define MAX_CHANNELS 150
+#define MAX_CACHED_FILES 16
+#define MAX_MUSIC_FILES 2
 
 #if SDL_VERSION_ATLEAST(2, 0, 7) 
 #define USE_SDL_AUDIOSTREAM 
 #endif
 
+typedef enum {
+    FILE_NOT_LOADED = 0,
+    FILE_QUEUED = 1,
+    FILE_LOADED = 2,
+    FILE_FAILED = 3
+} file_state;
+
 typedef struct {
-    const char *filename;
+    char filename[FILE_NAME_MAX];
+    Mix_Chunk *chunk;
+    SDL_atomic_t state;
+    unsigned int last_used;
+} sound_file;
+
+typedef struct {
+    sound_file file;
     Mix_Chunk *chunk;
 } sound_channel;
 
+typedef struct {
+    char filename[FILE_NAME_MAX];
+    char fallback_filename[FILE_NAME_MAX];
+    Mix_Music *music;
+    SDL_atomic_t state;
+} music_file;
+
 static struct {
     int initialized;
     Mix_Music *music;
+    music_file music_files[MAX_MUSIC_FILES];
+    music_file *next_music;
+    struct {
+        int waiting;
+        char filename[FILE_NAME_MAX];
+        char fallback_filename[FILE_NAME_MAX];
+    } requested_music;
+    int music_volume_pct;
     sound_channel channels[MAX_CHANNELS];
+    sound_file cached_files[MAX_CACHED_FILES];
+    unsigned int use_counter;
+    struct {
+        sound_file *file;
+        int channel;
+        int volume_pct;
+    } pending;
+    int cache_hits;
+    int cache_misses;
 } data;
 
 static struct {
@@ -88,12 +129,44 @@ void sound_device_open(void)
     }
 }
 
+static void free_file(sound_file *file)
+{
+    if (SDL_AtomicGet(&file->state) == FILE_LOADED) {
+        Mix_FreeChunk(file->chunk);
+    }
+    file->chunk = 0;
+    SDL_AtomicSet(&file->state, FILE_NOT_LOADED);
+}
+
+static void free_music_file(music_file *file)
+{
+    if (file->music) {
+        Mix_FreeMusic(file->music);
+        file->music = 0;
+    }
+    SDL_AtomicSet(&file->state, FILE_NOT_LOADED);
+}
+
 void sound_device_close(void)
 {
     if (data.initialized) {
         for (int i = 0; i < MAX_CHANNELS; i++) {
             sound_device_stop_channel(i);
         }
+        sound_device_stop_music();
+        // the loader may still be decoding a file
+        system_wait_for_background_task(BACKGROUND_TASK_LOAD_SOUNDS);
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            free_file(&data.channels[i].file);
+        }
+        for (int i = 0; i < MAX_CACHED_FILES; i++) {
+            free_file(&data.cached_files[i]);
+        }
+        for (int i = 0; i < MAX_MUSIC_FILES; i++) {
+            free_music_file(&data.music_files[i]);
+        }
+        log_info("Sound file cache hits:", 0, data.cache_hits);
+        log_info("Sound file cache misses:", 0, data.cache_misses);
         Mix_CloseAudio();
         data.initialized = 0;
     }
@@ -117,12 +190,113 @@ static Mix_Chunk *load_chunk(const char *filename)
     }
 }
 
+static int load_file_if_queued(sound_file *file)
+{
+    if (SDL_AtomicGet(&file->state) != FILE_QUEUED) {
+        return 0;
+    }
+    file->chunk = load_chunk(file->filename);
+    SDL_AtomicSet(&file->state, file->chunk ? FILE_LOADED : FILE_FAILED);
+    return 1;
+}
+
+static Mix_Music *load_music(const char *filename)
+{
+#ifdef __vita__
+    FILE *fp = file_open(filename, "rb");
+    if (!fp) {
+        return NULL;
+    }
+    SDL_RWops *sdl_fp = SDL_RWFromFP(fp, SDL_TRUE);
+    Mix_Music *music = Mix_LoadMUSType_RW(sdl_fp, file_has_extension(filename, "mp3") ? MUS_MP3 : MUS_WAV, SDL_TRUE);
+#else
+    Mix_Music *music = Mix_LoadMUS(filename);
+#endif
+    if (!music) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Error opening music file '%s'. Reason: %s", filename, Mix_GetError());
+    }
+    return music;
+}
+
+static int load_music_if_queued(void)
+{
+    int loaded = 0;
+    for (int i = 0; i < MAX_MUSIC_FILES; i++) {
+        music_file *file = &data.music_files[i];
+        if (SDL_AtomicGet(&file->state) != FILE_QUEUED) {
+            continue;
+        }
+        file->music = load_music(file->filename);
+        if (!file->music && file->fallback_filename[0]) {
+            file->music = load_music(file->fallback_filename);
+            strcpy(file->filename, file->fallback_filename);
+        }
+        SDL_AtomicSet(&file->state, file->music ? FILE_LOADED : FILE_FAILED);
+        loaded++;
+    }
+    return loaded;
+}
+
+static void load_queued_files(void *unused)
+{
+    int loaded;
+    do {
+        // music goes first so a new track does not wait for all sound effects to load
+        loaded = load_music_if_queued();
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            loaded += load_file_if_queued(&data.channels[i].file);
+        }
+        for (int i = 0; i < MAX_CACHED_FILES; i++) {
+            loaded += load_file_if_queued(&data.cached_files[i]);
+        }
+    } while (loaded);
+}
+
+static void start_loading(void)
+{
+    if (system_background_task_running(BACKGROUND_TASK_LOAD_SOUNDS)) {
+        // queued files are picked up by the running loader, or on the next update
+        return;
+    }
+    if (!system_start_background_task(BACKGROUND_TASK_LOAD_SOUNDS, load_queued_files, 0)) {
+        // no threads available: load on this thread instead
+        load_queued_files(0);
+    }
+}
+
+static void queue_file(sound_file *file)
+{
+    SDL_AtomicSet(&file->state, FILE_QUEUED);
+    start_loading();
+}
+
+static int is_file_loaded(sound_file *file)
+{
+    switch (SDL_AtomicGet(&file->state)) {
+        case FILE_LOADED:
+            data.cache_hits++;
+            return 1;
+        case FILE_NOT_LOADED:
+            if (!file->filename[0]) {
+                return 0;
+            }
+            queue_file(file);
+            // fallthrough
+        case FILE_QUEUED:
+            data.cache_misses++;
+            return SDL_AtomicGet(&file->state) == FILE_LOADED;
+        default:
+            return 0;
+    }
+}
+
 static int load_channel(sound_channel *channel)
 {
-    if (!channel->chunk && channel->filename) {
-        channel->chunk = load_chunk(channel->filename);
+    if (!is_file_loaded(&channel->file)) {
+        return 0;
     }
-    return channel->chunk ? 1 : 0;
+    channel->chunk = channel->file.chunk;
+    return 1;
 }
 
 void sound_device_init_channels(int num_channels, char filenames[][CHANNEL_FILENAME_MAX])
@@ -135,9 +309,136 @@ void sound_device_init_channels(int num_channels, char filenames[][CHANNEL_FILEN
         log_info("Loading audio files", 0, 0);
         for (int i = 0; i < num_channels; i++) {
             data.channels[i].chunk = 0;
-            data.channels[i].filename = filenames[i][0] ? filenames[i] : 0;
+            strncpy(data.channels[i].file.filename, filenames[i], CHANNEL_FILENAME_MAX);
+        }
+    }
+}
+
+void sound_device_preload_channels(int first_channel, int last_channel)
+{
+    if (!data.initialized) {
+        return;
+    }
+    for (int i = first_channel; i <= last_channel && i < MAX_CHANNELS; i++) {
+        sound_file *file = &data.channels[i].file;
+        if (file->filename[0] && SDL_AtomicGet(&file->state) == FILE_NOT_LOADED) {
+            SDL_AtomicSet(&file->state, FILE_QUEUED);
+        }
+    }
+    start_loading();
+}
+
+static Mix_Music *start_music(Mix_Music *music, const char *filename)
+{
+    if (music && Mix_PlayMusic(music, -1) == -1) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Error playing music file '%s'. Reason: %s", filename, Mix_GetError());
+        Mix_FreeMusic(music);
+        return 0;
+    }
+    return music;
+}
+
+static void play_loaded_music(music_file *file)
+{
+    // Starting the new music halts the current music, so there is no gap while loading
+    Mix_Music *previous = data.music;
+    data.music = start_music(file->music, file->filename);
+    file->music = 0;
+    if (!data.music && file->fallback_filename[0] && strcmp(file->filename, file->fallback_filename) != 0) {
+        data.music = start_music(load_music(file->fallback_filename), file->fallback_filename);
+    }
+    if (data.music) {
+        sound_device_set_music_volume(data.music_volume_pct);
+    }
+    if (previous) {
+        Mix_FreeMusic(previous);
+    }
+}
+
+static music_file *get_free_music_file(void)
+{
+    music_file *free_file = 0;
+    for (int i = 0; i < MAX_MUSIC_FILES; i++) {
+        // music that finished loading but was not played is no longer wanted
+        if (SDL_AtomicGet(&data.music_files[i].state) != FILE_QUEUED) {
+            free_music_file(&data.music_files[i]);
+            if (!free_file) {
+                free_file = &data.music_files[i];
+            }
+        }
+    }
+    return free_file;
+}
+
+static void queue_requested_music(void)
+{
+    music_file *file = get_free_music_file();
+    if (!file) {
+        // the loader is still busy with earlier tracks, try again next frame
+        return;
+    }
+    strcpy(file->filename, data.requested_music.filename);
+    strcpy(file->fallback_filename, data.requested_music.fallback_filename);
+    data.requested_music.waiting = 0;
+    data.next_music = file;
+    SDL_AtomicSet(&file->state, FILE_QUEUED);
+    start_loading();
+}
+
+static void update_music(void)
+{
+    if (data.requested_music.waiting) {
+        queue_requested_music();
+    }
+    music_file *file = data.next_music;
+    if (!file) {
+        return;
+    }
+    switch (SDL_AtomicGet(&file->state)) {
+        case FILE_QUEUED:
+            start_loading();
+            return;
+        case FILE_LOADED:
+            play_loaded_music(file);
+            break;
+        default:
+            sound_device_stop_music();
+            break;
+    }
+    data.next_music = 0;
+    SDL_AtomicSet(&file->state, FILE_NOT_LOADED);
+}
+
+void sound_device_update(void)
+{
+    if (!data.initialized) {
+        return;
+    }
+    update_music();
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        if (SDL_AtomicGet(&data.channels[i].file.state) == FILE_QUEUED) {
+            start_loading();
+            break;
         }
     }
+    sound_file *file = data.pending.file;
+    if (file && SDL_AtomicGet(&file->state) != FILE_QUEUED) {
+        data.pending.file = 0;
+        if (SDL_AtomicGet(&file->state) == FILE_LOADED) {
+            sound_channel *ch = &data.channels[data.pending.channel];
+            ch->chunk = file->chunk;
+            sound_device_set_channel_volume(data.pending.channel, data.pending.volume_pct);
+            Mix_PlayChannel(data.pending.channel, ch->chunk, 0);
+        }
+    } else if (file) {
+        start_loading();
+    }
+}
+
+void sound_device_get_cache_stats(int *hits, int *misses)
+{
+    *hits = data.cache_hits;
+    *misses = data.cache_misses;
 }
 
 int sound_device_is_channel_playing(int channel)
@@ -157,44 +458,66 @@ void sound_device_set_channel_volume(int channel, int volume_pct)
     }
 }
 
-int sound_device_play_music(const char *filename, int volume_pct)
+int sound_device_play_music(const char *filename, const char *fallback_filename, int volume_pct)
 {
-    if (data.initialized) {
-        sound_device_stop_music();
+    if (!data.initialized || !filename) {
+        return 0;
+    }
+    data.music_volume_pct = volume_pct;
+    data.next_music = 0;
+    strncpy(data.requested_music.filename, filename, FILE_NAME_MAX - 1);
+    data.requested_music.filename[FILE_NAME_MAX - 1] = 0;
+    strncpy(data.requested_music.fallback_filename, fallback_filename ? fallback_filename : "", FILE_NAME_MAX - 1);
+    data.requested_music.fallback_filename[FILE_NAME_MAX - 1] = 0;
+    data.requested_music.waiting = 1;
+    update_music();
+    return 1;
+}
 
-#ifdef __vita__
-        FILE *fp = file_open(filename, "rb");
-        if (!fp) {
-            return 0;
+static sound_file *get_cached_file(const char *filename)
+{
+    sound_file *oldest = 0;
+    for (int i = 0; i < MAX_CACHED_FILES; i++) {
+        sound_file *file = &data.cached_files[i];
+        if (file->filename[0] && strcmp(file->filename, filename) == 0) {
+            file->last_used = ++data.use_counter;
+            return file;
         }
-        SDL_RWops *sdl_fp = SDL_RWFromFP(fp, SDL_TRUE);
-        data.music = Mix_LoadMUSType_RW(sdl_fp, file_has_extension(filename, "mp3") ? MUS_MP3 : MUS_WAV, SDL_TRUE);
-#else
-        data.music = Mix_LoadMUS(filename);
-#endif
-        if (!data.music) {
-            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Error opening music file '%s'. Reason: %s", filename, Mix_GetError());
-        } else {
-            if (Mix_PlayMusic(data.music, -1) == -1) {
-                data.music = 0;
-                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Error playing music file '%s'. Reason: %s", filename, Mix_GetError());
-            } else {
-                sound_device_set_music_volume(volume_pct);
-            }
+        if (SDL_AtomicGet(&file->state) != FILE_QUEUED && (!oldest || file->last_used < oldest->last_used)) {
+            oldest = file;
         }
-        return data.music ? 1 : 0;
     }
-    return 0;
+    if (!oldest) {
+        return 0;
+    }
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        if (oldest->chunk && data.channels[i].chunk == oldest->chunk) {
+            sound_device_stop_channel(i);
+        }
+    }
+    free_file(oldest);
+    strncpy(oldest->filename, filename, FILE_NAME_MAX - 1);
+    oldest->last_used = ++data.use_counter;
+    return oldest;
 }
 
 void sound_device_play_file_on_channel(const char *filename, int channel, int volume_pct)
 {
     if (data.initialized) {
         sound_device_stop_channel(channel);
-        data.channels[channel].chunk = load_chunk(filename);
-        if (data.channels[channel].chunk) {
+        sound_file *file = get_cached_file(filename);
+        if (!file) {
+            return;
+        }
+        if (is_file_loaded(file)) {
+            data.channels[channel].chunk = file->chunk;
             sound_device_set_channel_volume(channel, volume_pct);
-            Mix_PlayChannel(channel, data.channels[channel].chunk, 0);
+            Mix_PlayChannel(channel, file->chunk, 0);
+        } else if (SDL_AtomicGet(&file->state) == FILE_QUEUED) {
+            // played by sound_device_update once the file is loaded
+            data.pending.file = file;
+            data.pending.channel = channel;
+            data.pending.volume_pct = volume_pct;
         }
     }
 }
@@ -225,6 +548,9 @@ void sound_device_play_channel_panned(int channel, int volume_pct, int left_pct,
 void sound_device_stop_music(void)
 {
     if (data.initialized) {
+        // music that is still loading will not be played
+        data.requested_music.waiting = 0;
+        data.next_music = 0;
         if (data.music) {
             Mix_HaltMusic();
             Mix_FreeMusic(data.music);
@@ -239,9 +565,11 @@ void sound_device_stop_channel(int channel)
         sound_channel *ch = &data.channels[channel];
         if (ch->chunk) {
             Mix_HaltChannel(channel);
-            Mix_FreeChunk(ch->chunk);
             ch->chunk = 0;
         }
+        if (data.pending.file && data.pending.channel == channel) {
+            data.pending.file = 0;
+        }
     }
 }
 
@@ -0,0 +1,9 @@
+// DO NOT EDIT. This file is generated by CMake.
+// Run CMake configure step to update it.
+#ifndef PLATFORM_VERSION_H
+#define PLATFORM_VERSION_H
+
+#define JULIUS_VERSION "1.3.1"
+#define JULIUS_VERSION_SUFFIX "-20261019-c68538c-dirty"
+
+#endif // PLATFORM_VERSION_H
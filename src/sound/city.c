@@ -189,6 +189,8 @@ void sound_city_init(void)
     channels[61].channel = SOUND_CHANNEL_CITY_EMPTY_LAND;
     channels[62].channel = SOUND_CHANNEL_CITY_RIVER;
     channels[63].channel = SOUND_CHANNEL_CITY_MISSION_POST;
+
+    sound_device_preload_channels(SOUND_CHANNEL_CITY_MIN, SOUND_CHANNEL_CITY_MAX);
 }
 
 void sound_city_set_volume(int percentage)
@@ -7,12 +7,40 @@ void sound_device_open(void);
 void sound_device_close(void);
 
 void sound_device_init_channels(int num_channels, char filenames[][CHANNEL_FILENAME_MAX]);
+
+/**
+ * Loads and decodes the sound files of the channels in the background,
+ * so playing them later does not have to wait for the disk
+ * @param first_channel First channel to load
+ * @param last_channel Last channel to load, inclusive
+ */
+void sound_device_preload_channels(int first_channel, int last_channel);
+
+/**
+ * Starts sounds and music whose files finished loading in the background. Call once per frame.
+ */
+void sound_device_update(void);
+
+/**
+ * Gets how often a sound could be played from memory right away
+ * @param hits Number of plays of a file that was already loaded
+ * @param misses Number of plays that had to wait for the file to load
+ */
+void sound_device_get_cache_stats(int *hits, int *misses);
+
 int sound_device_is_channel_playing(int channel);
 
 void sound_device_set_music_volume(int volume_pct);
 void sound_device_set_channel_volume(int channel, int volume_pct);
 
-int sound_device_play_music(const char *filename, int volume_pct);
+/**
+ * Plays music. The music is loaded in the background, the current music keeps playing until it is ready.
+ * @param filename Music file to play
+ * @param fallback_filename File to play if the music file cannot be loaded, may be NULL
+ * @param volume_pct Volume percentage
+ * @return Boolean true if the music is being loaded, false if there is no music file or no sound device
+ */
+int sound_device_play_music(const char *filename, const char *fallback_filename, int volume_pct);
 void sound_device_play_file_on_channel(const char *filename, int channel, int volume_pct);
 void sound_device_play_channel(int channel, int volume_pct);
 void sound_device_play_channel_panned(int channel, int volume_pct, int left_pct, int right_pct);
@@ -1,11 +1,14 @@
 #include "music.h"
 
 #include "core/dir.h"
+#include "core/file.h"
 #include "city/figures.h"
 #include "city/population.h"
 #include "game/settings.h"
 #include "sound/device.h"
 
+#include <string.h>
+
 enum {
     TRACK_NONE = 0,
     TRACK_CITY_1 = 1,
@@ -55,15 +58,28 @@ void sound_music_set_volume(int percentage)
 
 static void play_track(int track)
 {
-    sound_device_stop_music();
     if (track <= TRACK_NONE || track >= TRACK_MAX) {
+        sound_device_stop_music();
         return;
     }
-    const char *mp3_track = dir_get_file(mp3_tracks[track], NOT_LOCALIZED);
+    // dir_get_file reuses its buffer, so keep a copy of the mp3 file name
+    char mp3_track[FILE_NAME_MAX];
+    const char *mp3_file = dir_get_file(mp3_tracks[track], NOT_LOCALIZED);
+    if (mp3_file) {
+        strncpy(mp3_track, mp3_file, FILE_NAME_MAX - 1);
+        mp3_track[FILE_NAME_MAX - 1] = 0;
+    }
+    const char *wav_track = dir_get_file(tracks[track], NOT_LOCALIZED);
 
     int volume = setting_sound(SOUND_MUSIC)->volume;
-    if (!mp3_track || !sound_device_play_music(mp3_track, volume)) {
-        sound_device_play_music(dir_get_file(tracks[track], NOT_LOCALIZED), volume);
+    int playing;
+    if (mp3_file) {
+        playing = sound_device_play_music(mp3_track, wav_track, volume);
+    } else {
+        playing = sound_device_play_music(wav_track, 0, volume);
+    }
+    if (!playing) {
+        sound_device_stop_music();
     }
     data.current_track = track;
 }
@@ -187,6 +187,7 @@ void sound_system_init(void)
     
     sound_device_open();
     sound_device_init_channels(SOUND_CHANNEL_MAX, channel_filenames);
+    sound_device_preload_channels(SOUND_CHANNEL_EFFECTS_MIN, SOUND_CHANNEL_EFFECTS_MAX);
 
     sound_city_set_volume(setting_sound(SOUND_CITY)->volume);
     sound_effect_set_volume(setting_sound(SOUND_EFFECTS)->volume);
@@ -194,6 +195,11 @@ void sound_system_init(void)
     sound_speech_set_volume(setting_sound(SOUND_SPEECH)->volume);
 }
 
+void sound_system_update(void)
+{
+    sound_device_update();
+}
+
 void sound_system_shutdown(void)
 {
     sound_device_close();
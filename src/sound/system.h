@@ -3,6 +3,8 @@
 
 void sound_system_init(void);
 
+void sound_system_update(void);
+
 void sound_system_shutdown(void);
 
 #endif // SOUND_SYSTEM_H
@@ -6,6 +6,7 @@
 #include "city/warning.h"
 #include "core/string.h"
 #include "figure/formation_legion.h"
+#include "game/replay.h"
 #include "game/settings.h"
 #include "game/state.h"
 #include "graphics/graphics.h"
@@ -409,6 +410,7 @@ static void military_map_click(int legion_formation_id, const map_tile *tile)
     if (m->in_distant_battle || m->cursed_by_mars) {
         return;
     }
+    game_replay_record_unsupported_command();
     int other_formation_id = formation_legion_at_building(tile->grid_offset);
     if (other_formation_id && other_formation_id == legion_formation_id) {
         formation_legion_return_home(m);
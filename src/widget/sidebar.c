@@ -12,6 +12,7 @@
 #include "core/lang.h"
 #include "core/string.h"
 #include "game/orientation.h"
+#include "game/replay.h"
 #include "game/settings.h"
 #include "game/state.h"
 #include "game/undo.h"
@@ -536,6 +537,7 @@ static void button_build(int submenu, int param2)
 
 static void button_undo(int param1, int param2)
 {
+    game_replay_record_undo();
     game_undo_perform();
     window_invalidate();
 }
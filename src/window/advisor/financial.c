@@ -2,6 +2,7 @@
 
 #include "city/finance.h"
 #include "core/calc.h"
+#include "game/replay.h"
 #include "graphics/arrow_button.h"
 #include "graphics/graphics.h"
 #include "graphics/image.h"
@@ -111,6 +112,7 @@ static int handle_mouse(const mouse *m)
 
 static void button_change_taxes(int is_down, int param2)
 {
+    game_replay_record_tax_change(is_down ? -1 : 1);
     city_finance_change_tax_percentage(is_down ? -1 : 1);
     city_finance_estimate_taxes();
     city_finance_calculate_totals();
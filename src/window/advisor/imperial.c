@@ -7,6 +7,7 @@
 #include "city/resource.h"
 #include "empire/city.h"
 #include "figure/formation_legion.h"
+#include "game/replay.h"
 #include "graphics/generic_button.h"
 #include "graphics/image.h"
 #include "graphics/lang_text.h"
@@ -227,6 +228,7 @@ static void confirm_nothing(int accepted)
 static void confirm_send_troops(int accepted)
 {
     if (accepted) {
+        game_replay_record_unsupported_command();
         formation_legions_dispatch_to_distant_battle();
         window_empire_show();
     }
@@ -235,6 +237,7 @@ static void confirm_send_troops(int accepted)
 static void confirm_send_goods(int accepted)
 {
     if (accepted) {
+        game_replay_record_unsupported_command();
         scenario_request_dispatch(selected_request_id);
     }
 }
@@ -243,6 +246,7 @@ static void button_request(int index, int param2)
 {
     int status = get_request_status(index);
     if (status) {
+        game_replay_record_unsupported_command();
         city_military_clear_empire_service_legions();
         switch (status) {
             case STATUS_NO_LEGIONS_AVAILABLE:
@@ -3,6 +3,7 @@
 #include "city/finance.h"
 #include "city/labor.h"
 #include "core/calc.h"
+#include "game/replay.h"
 #include "graphics/arrow_button.h"
 #include "graphics/generic_button.h"
 #include "graphics/image.h"
@@ -108,6 +109,7 @@ static int handle_mouse(const mouse *m)
 
 static void arrow_button_wages(int is_down, int param2)
 {
+    game_replay_record_wage_change(is_down ? -1 : 1);
     city_labor_change_wages(is_down ? -1 : 1);
     city_finance_estimate_wages();
     city_finance_calculate_totals();
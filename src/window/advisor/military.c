@@ -4,6 +4,7 @@
 #include "city/military.h"
 #include "city/view.h"
 #include "figure/formation_legion.h"
+#include "game/replay.h"
 #include "graphics/generic_button.h"
 #include "graphics/image.h"
 #include "graphics/lang_text.h"
@@ -175,6 +176,7 @@ static void button_return_to_fort(int legion_id, int param2)
 {
     formation *m = formation_get(formation_for_legion(legion_id));
     if (!m->in_distant_battle) {
+        game_replay_record_unsupported_command();
         formation_legion_return_home(m);
         window_invalidate();
     }
@@ -183,6 +185,7 @@ static void button_return_to_fort(int legion_id, int param2)
 static void button_empire_service(int legion_id, int param2)
 {
     int formation_id = formation_for_legion(legion_id);
+    game_replay_record_unsupported_command();
     formation_toggle_empire_service(formation_id);
     formation_calculate_figures();
     window_invalidate();
@@ -6,6 +6,7 @@
 #include "city/buildings.h"
 #include "city/resource.h"
 #include "figure/figure.h"
+#include "game/replay.h"
 #include "game/resource.h"
 #include "graphics/generic_button.h"
 #include "graphics/image.h"
@@ -456,12 +457,14 @@ static void toggle_resource_state(int index, int param2)
     } else {
         resource = city_resource_get_available_foods()->items[index-1];
     }
+    game_replay_record_unsupported_command();
     building_storage_cycle_resource_state(b->storage_id, resource);
     window_invalidate();
 }
 
 static void granary_orders(int index, int param2)
 {
+    game_replay_record_unsupported_command();
     int storage_id = building_get(data.building_id)->storage_id;
     if (index == 0) {
         building_storage_toggle_empty_all(storage_id);
@@ -473,6 +476,7 @@ static void granary_orders(int index, int param2)
 
 static void warehouse_orders(int index, int param2)
 {
+    game_replay_record_unsupported_command();
     if (index == 0) {
         int storage_id = building_get(data.building_id)->storage_id;
         building_storage_toggle_empty_all(storage_id);
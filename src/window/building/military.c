@@ -5,6 +5,7 @@
 #include "core/calc.h"
 #include "core/log.h"
 #include "figure/formation_legion.h"
+#include "game/replay.h"
 #include "graphics/generic_button.h"
 #include "graphics/image.h"
 #include "graphics/lang_text.h"
@@ -386,6 +387,7 @@ static void button_return_to_fort(int param1, int param2)
 {
     formation *m = formation_get(data.context_for_callback->formation_id);
     if (!m->in_distant_battle && m->is_at_fort != 1) {
+        game_replay_record_unsupported_command();
         formation_legion_return_home(m);
         window_city_show();
     }
@@ -422,6 +424,7 @@ static void button_layout(int index, int param2)
             case 4: new_layout = FORMATION_MOP_UP; break;
         }
     }
+    game_replay_record_unsupported_command();
     formation_legion_change_layout(m, new_layout);
     switch (index) {
         case 0: sound_speech_play_file("wavs/cohort1.wav"); break;
@@ -2,6 +2,7 @@
 
 #include "city/emperor.h"
 #include "core/calc.h"
+#include "game/replay.h"
 #include "game/resource.h"
 #include "graphics/arrow_button.h"
 #include "graphics/generic_button.h"
@@ -114,6 +115,7 @@ static void button_set_amount(int amount_id, int param2)
 
 static void button_donate(int param1, int param2)
 {
+    game_replay_record_unsupported_command();
     city_emperor_donate_savings_to_city();
     window_advisors_show();
 }
@@ -9,6 +9,7 @@
 #include "empire/object.h"
 #include "empire/trade_route.h"
 #include "empire/type.h"
+#include "game/replay.h"
 #include "game/tutorial.h"
 #include "graphics/generic_button.h"
 #include "graphics/graphics.h"
@@ -614,6 +615,7 @@ static void button_advisor(int advisor, int param2)
 static void confirmed_open_trade(int accepted)
 {
     if (accepted) {
+        game_replay_record_unsupported_command();
         empire_city_open_trade(data.selected_city);
         building_menu_update();
         window_trade_opened_show(data.selected_city);
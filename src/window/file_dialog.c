@@ -10,6 +10,7 @@
 #include "core/time.h"
 #include "game/file.h"
 #include "game/file_editor.h"
+#include "game/saved_game_index.h"
 #include "graphics/generic_button.h"
 #include "graphics/graphics.h"
 #include "graphics/image.h"
@@ -94,11 +95,22 @@ static void init(file_type type, file_dialog_type dialog_type)
     data.scroll_position = 0;
 
     data.file_list = dir_find_files_with_extension(data.file_data->extension);
+    if (type == FILE_TYPE_SAVED_GAME) {
+        saved_game_index_refresh(data.file_list);
+    }
 
     strncpy(data.selected_file, data.file_data->last_loaded_file, FILE_NAME_MAX);
     keyboard_start_capture(data.typed_name, FILE_NAME_MAX, 0, &file_name_input, FONT_NORMAL_WHITE);
 }
 
+static void close_dialog(void)
+{
+    keyboard_stop_capture();
+    if (data.type == FILE_TYPE_SAVED_GAME) {
+        saved_game_index_save();
+    }
+}
+
 static void draw_scrollbar_dot(void)
 {
     if (data.file_list->num_files > 12) {
@@ -115,12 +127,40 @@ static void draw_scrollbar_dot(void)
     }
 }
 
+static const char *get_info_filename(void)
+{
+    int index = data.scroll_position + data.focus_button_id - 1;
+    if (data.focus_button_id > 0 && index < data.file_list->num_files) {
+        return data.file_list->files[index];
+    }
+    return data.selected_file;
+}
+
+static void draw_saved_game_info(void)
+{
+    const saved_game_info *info = saved_game_index_get(get_info_filename());
+    if (!info) {
+        return;
+    }
+    uint8_t scenario_name[sizeof(info->scenario_name)];
+    string_copy(info->scenario_name, scenario_name, sizeof(scenario_name));
+    text_ellipsize(scenario_name, FONT_NORMAL_BLACK, 220);
+    text_draw(scenario_name, 144, 368, FONT_NORMAL_BLACK, 0);
+    lang_text_draw_month_year_max_width(info->month, info->year, 376, 368, 120, FONT_NORMAL_BLACK, 0);
+
+    int width = lang_text_draw(6, 0, 144, 386, FONT_NORMAL_BLACK);
+    text_draw_number(info->treasury, '@', " ", 144 + width, 386, FONT_NORMAL_BLACK);
+    width = lang_text_draw(6, 1, 304, 386, FONT_NORMAL_BLACK);
+    text_draw_number(info->population, '@', " ", 304 + width, 386, FONT_NORMAL_BLACK);
+}
+
 static void draw_foreground(void)
 {
     graphics_in_dialog();
     uint8_t file[FILE_NAME_MAX];
 
-    outer_panel_draw(128, 40, 24, 21);
+    // saved games get extra room for the summary of the hovered file
+    outer_panel_draw(128, 40, 24, data.type == FILE_TYPE_SAVED_GAME ? 24 : 21);
     input_box_draw(&file_name_input);
     inner_panel_draw(144, 120, 20, 13);
 
@@ -151,6 +191,9 @@ static void draw_foreground(void)
     text_draw(data.typed_name, 160, 90, FONT_NORMAL_WHITE, 0);
     text_draw_cursor(160, 91, keyboard_is_insert());
     draw_scrollbar_dot();
+    if (data.type == FILE_TYPE_SAVED_GAME) {
+        draw_saved_game_info();
+    }
 
     graphics_reset_dialog();
 }
@@ -198,7 +241,7 @@ static void handle_mouse(const mouse *m)
         return;
     }
     if (m->right.went_up || (m->is_touch && m->left.double_click)) {
-        keyboard_stop_capture();
+        close_dialog();
         window_go_back();
     }
 }
@@ -230,7 +273,7 @@ static const char *get_chosen_filename(void)
 static void button_ok_cancel(int is_ok, int param2)
 {
     if (!is_ok) {
-        keyboard_stop_capture();
+        close_dialog();
         window_go_back();
         return;
     }
@@ -244,7 +287,7 @@ static void button_ok_cancel(int is_ok, int param2)
     if (data.dialog_type == FILE_DIALOG_LOAD) {
         if (data.type == FILE_TYPE_SAVED_GAME) {
             if (game_file_load_saved_game(filename)) {
-                keyboard_stop_capture();
+                close_dialog();
                 window_city_show();
             } else {
                 data.message_not_exist_start_time = time_get_millis();
@@ -252,7 +295,7 @@ static void button_ok_cancel(int is_ok, int param2)
             }
         } else if (data.type == FILE_TYPE_SCENARIO) {
             if (game_file_editor_load_scenario(filename)) {
-                keyboard_stop_capture();
+                close_dialog();
                 window_editor_map_show();
             } else {
                 data.message_not_exist_start_time = time_get_millis();
@@ -260,7 +303,7 @@ static void button_ok_cancel(int is_ok, int param2)
             }
         }
     } else if (data.dialog_type == FILE_DIALOG_SAVE) {
-        keyboard_stop_capture();
+        close_dialog();
         if (data.type == FILE_TYPE_SAVED_GAME) {
             game_file_write_saved_game(filename);
             window_city_show();
@@ -1,6 +1,7 @@
 #include "gift_to_emperor.h"
 
 #include "city/emperor.h"
+#include "game/replay.h"
 #include "game/resource.h"
 #include "graphics/generic_button.h"
 #include "graphics/graphics.h"
@@ -106,6 +107,7 @@ static void button_set_gift(int gift_id, int param2)
 static void button_send_gift(int param1, int param2)
 {
     if (city_emperor_can_send_gift(GIFT_MODEST)) {
+        game_replay_record_unsupported_command();
         city_emperor_send_gift();
         window_advisors_show();
     }
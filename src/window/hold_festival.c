@@ -5,6 +5,7 @@
 #include "city/finance.h"
 #include "city/gods.h"
 #include "core/image_group.h"
+#include "game/replay.h"
 #include "game/resource.h"
 #include "graphics/generic_button.h"
 #include "graphics/graphics.h"
@@ -146,6 +147,7 @@ static void button_hold_festival(int param1, int param2)
     if (city_finance_out_of_money()) {
         return;
     }
+    game_replay_record_unsupported_command();
     city_festival_schedule();
     window_advisors_show();
 }
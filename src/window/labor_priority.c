@@ -1,6 +1,7 @@
 #include "labor_priority.h"
 
 #include "city/labor.h"
+#include "game/replay.h"
 #include "graphics/generic_button.h"
 #include "graphics/graphics.h"
 #include "graphics/lang_text.h"
@@ -106,6 +107,7 @@ static void handle_mouse(const mouse *m)
 
 static void button_set_priority(int new_priority, int param2)
 {
+    game_replay_record_unsupported_command();
     city_labor_set_priority(data.category, new_priority);
     window_go_back();
 }
@@ -5,6 +5,7 @@
 #include "core/calc.h"
 #include "core/image_group.h"
 #include "empire/city.h"
+#include "game/replay.h"
 #include "graphics/arrow_button.h"
 #include "graphics/generic_button.h"
 #include "graphics/graphics.h"
@@ -192,23 +193,27 @@ static void button_ok(int param1, int param2)
 
 static void button_export_up_down(int is_down, int param2)
 {
+    game_replay_record_unsupported_command();
     city_resource_change_export_over(data.resource, is_down ? -1 : 1);
 }
 
 static void button_toggle_industry(int param1, int param2)
 {
     if (building_count_industry_total(data.resource) > 0) {
+        game_replay_record_unsupported_command();
         city_resource_toggle_mothballed(data.resource);
     }
 }
 
 static void button_toggle_trade(int param1, int param2)
 {
+    game_replay_record_unsupported_command();
     city_resource_cycle_trade_status(data.resource);
 }
 
 static void button_toggle_stockpile(int param1, int param2)
 {
+    game_replay_record_unsupported_command();
     city_resource_toggle_stockpiled(data.resource);
 }
 
@@ -1,6 +1,7 @@
 #include "victory_dialog.h"
 
 #include "city/victory.h"
+#include "game/replay.h"
 #include "graphics/generic_button.h"
 #include "graphics/graphics.h"
 #include "graphics/lang_text.h"
@@ -83,6 +84,7 @@ static void button_accept(int param1, int param2)
 
 static void button_continue_governing(int months, int param2)
 {
+    game_replay_record_unsupported_command();
     city_victory_continue_governing(months);
     window_city_show();
     city_victory_reset();
@@ -0,0 +1,83 @@
+#include "city/finance.h"
+#include "city/population.h"
+#include "core/dir.h"
+#include "core/file.h"
+#include "core/string.h"
+#include "game/file_io.h"
+#include "game/game.h"
+#include "game/saved_game_index.h"
+#include "game/time.h"
+#include "scenario/property.h"
+
+#include <stdio.h>
+
+static int compare_value(const char *filename, const char *source, const char *name, int actual, int expected)
+{
+    if (actual != expected) {
+        printf("%s: %s %s is %d, loaded game has %d\n", filename, source, name, actual, expected);
+        return 0;
+    }
+    return 1;
+}
+
+static int compare_info(const char *filename, const char *source, const saved_game_info *info)
+{
+    int ok = compare_value(filename, source, "treasury", info->treasury, city_finance_treasury());
+    ok &= compare_value(filename, source, "population", info->population, city_population());
+    ok &= compare_value(filename, source, "month", info->month, game_time_month());
+    ok &= compare_value(filename, source, "year", info->year, game_time_year());
+    if (!string_equals(info->scenario_name, scenario_name())) {
+        printf("%s: %s scenario name differs from the loaded game\n", filename, source);
+        ok = 0;
+    }
+    return ok;
+}
+
+// The summary shown in the file dialog is read from a few pieces of the saved game
+// at fixed offsets: it must match what a full load of the same file gives
+static int check_saved_game(const char *filename)
+{
+    saved_game_info info;
+    if (!game_file_io_read_saved_game_info(filename, &info)) {
+        printf("%s: unable to read summary\n", filename);
+        return 0;
+    }
+    const saved_game_info *indexed = saved_game_index_get(filename);
+    if (!indexed) {
+        printf("%s: not in saved game index\n", filename);
+        return 0;
+    }
+    if (!game_file_io_read_saved_game(filename, 0)) {
+        printf("%s: unable to load saved game\n", filename);
+        return 0;
+    }
+    int ok = compare_info(filename, "summary", &info);
+    ok &= compare_info(filename, "index", indexed);
+    printf("%s: treasury %d, population %d, %d/%d%s\n", filename, info.treasury, info.population,
+        info.month + 1, info.year, ok ? "" : " MISMATCH");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("Usage: savinfo FILE...\n");
+        return -1;
+    }
+    if (!game_pre_init() || !game_init()) {
+        printf("Unable to initialize game\n");
+        return 1;
+    }
+    // an index left by an earlier run would hide what is read from the files now
+    file_remove("julius-saves.idx");
+    dir_listing files = {argv + 1, argc - 1};
+    saved_game_index_refresh(&files);
+
+    int ok = 1;
+    for (int i = 1; i < argc; i++) {
+        ok &= check_saved_game(argv[i]);
+    }
+    saved_game_index_save();
+    game_exit();
+    return ok ? 0 : 1;
+}
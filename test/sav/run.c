@@ -1,7 +1,9 @@
 #include "core/backtrace.h"
+#include "core/file.h"
 #include "core/time.h"
 #include "game/file.h"
 #include "game/game.h"
+#include "game/replay.h"
 #include "game/settings.h"
 
 #ifdef _MSC_VER
@@ -49,7 +51,10 @@ static int run_autopilot(const char *input_saved_game, const char *output_saved_
         return 2;
     }
 
-    if (!game_file_load_saved_game(input_saved_game)) {
+    // a replay loads the saved game it was recorded from and plays the commands during the ticks
+    int loaded = file_has_extension(input_saved_game, "rpl") ?
+        game_replay_start_playback(input_saved_game) : game_file_load_saved_game(input_saved_game);
+    if (!loaded) {
         char wd[500];
         if (getcwd(wd, 500)) {
             printf("Unable to load saved game from %s\n", wd);
@@ -59,6 +64,10 @@ static int run_autopilot(const char *input_saved_game, const char *output_saved_
         return 3;
     }
     run_ticks(ticks_to_run);
+    if (game_replay_is_playing()) {
+        printf("Replay did not finish in %d ticks\n", ticks_to_run);
+        return 4;
+    }
     printf("Saving game to %s\n", output_saved_game);
     game_file_write_saved_game(output_saved_game);
     printf("Done\n");
@@ -0,0 +1,91 @@
+#include "sav_compare.h"
+
+#include "../src/core/zip.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BUFFER_SIZE 600000
+
+static const struct {
+    zip_compress_level level;
+    const char *name;
+} levels[] = {
+    {ZIP_COMPRESS_BEST, "best"},
+    {ZIP_COMPRESS_FAST, "fast"},
+};
+
+#define NUM_LEVELS (int) (sizeof(levels) / sizeof(levels[0]))
+
+static struct {
+    int iterations;
+    int errors;
+    long input_bytes[NUM_LEVELS];
+    long output_bytes[NUM_LEVELS];
+    double seconds[NUM_LEVELS];
+    double decompress_seconds[NUM_LEVELS];
+} bench;
+
+static unsigned char compressed[BUFFER_SIZE];
+static unsigned char decompressed[BUFFER_SIZE];
+
+static void compress_part(const char *name, const unsigned char *data, int length)
+{
+    for (int level = 0; level < NUM_LEVELS; level++) {
+        int output_length = 0;
+        clock_t start = clock();
+        for (int i = 0; i < bench.iterations; i++) {
+            output_length = BUFFER_SIZE;
+            if (!zip_compress(data, length, compressed, &output_length, levels[level].level)) {
+                printf("ERROR: unable to compress %s at level %s\n", name, levels[level].name);
+                bench.errors++;
+                return;
+            }
+        }
+        bench.seconds[level] += (double) (clock() - start) / CLOCKS_PER_SEC;
+        bench.input_bytes[level] += (long) length * bench.iterations;
+        bench.output_bytes[level] += (long) output_length * bench.iterations;
+
+        int decompressed_length = 0;
+        int ok = 1;
+        start = clock();
+        for (int i = 0; i < bench.iterations && ok; i++) {
+            decompressed_length = BUFFER_SIZE;
+            ok = zip_decompress(compressed, output_length, decompressed, &decompressed_length);
+        }
+        bench.decompress_seconds[level] += (double) (clock() - start) / CLOCKS_PER_SEC;
+        if (!ok || decompressed_length != length || memcmp(data, decompressed, length) != 0) {
+            printf("ERROR: %s does not survive a round trip at level %s\n", name, levels[level].name);
+            bench.errors++;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        printf("Usage: %s ITERATIONS FILE...\n", argv[0]);
+        return 1;
+    }
+    bench.iterations = atoi(argv[1]);
+    if (bench.iterations < 1) {
+        bench.iterations = 1;
+    }
+    for (int i = 2; i < argc; i++) {
+        if (!for_each_compressed_part(argv[i], compress_part)) {
+            bench.errors++;
+        }
+    }
+    printf("level     input    output  ratio  compress MB/s  decompress MB/s\n");
+    for (int level = 0; level < NUM_LEVELS; level++) {
+        double megabytes = bench.input_bytes[level] / (1024.0 * 1024.0);
+        printf("%-5s %9ld %9ld %5.1f%% %14.1f %16.1f\n", levels[level].name,
+            bench.input_bytes[level] / bench.iterations, bench.output_bytes[level] / bench.iterations,
+            bench.input_bytes[level] ? 100.0 * bench.output_bytes[level] / bench.input_bytes[level] : 0.0,
+            bench.seconds[level] > 0 ? megabytes / bench.seconds[level] : 0.0,
+            bench.decompress_seconds[level] > 0 ? megabytes / bench.decompress_seconds[level] : 0.0);
+    }
+    return bench.errors ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#include "../src/core/smacker.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TRACKS 7
+
+// FNV-1a
+static uint32_t update_checksum(uint32_t checksum, const uint8_t *data, int length)
+{
+    for (int i = 0; i < length; i++) {
+        checksum ^= data[i];
+        checksum *= 16777619u;
+    }
+    return checksum;
+}
+
+static uint32_t update_checksum_u32(uint32_t checksum, uint32_t value)
+{
+    uint8_t bytes[4] = {value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff, value >> 24};
+    return update_checksum(checksum, bytes, 4);
+}
+
+static int decode(const char *filename, int *num_frames, uint32_t *video, uint32_t *palette, uint32_t *audio)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+        printf("Unable to open %s\n", filename);
+        return 0;
+    }
+    smacker s = smacker_open(fp);
+    if (!s) {
+        printf("Unable to decode %s\n", filename);
+        return 0;
+    }
+    int width, height;
+    smacker_get_video_info(s, &width, &height, 0);
+    int tracks[MAX_TRACKS];
+    for (int i = 0; i < MAX_TRACKS; i++) {
+        smacker_get_audio_info(s, i, &tracks[i], 0, 0, 0);
+    }
+    *num_frames = 0;
+    *video = *palette = *audio = 2166136261u;
+    smacker_frame_status status = smacker_first_frame(s);
+    while (status == SMACKER_FRAME_OK) {
+        (*num_frames)++;
+        *video = update_checksum(*video, smacker_get_frame_video(s), width * height);
+        const color_t *colors = smacker_get_frame_palette(s);
+        for (int i = 0; i < 256; i++) {
+            *palette = update_checksum_u32(*palette, colors[i]);
+        }
+        for (int i = 0; i < MAX_TRACKS; i++) {
+            if (tracks[i]) {
+                int size = smacker_get_frame_audio_size(s, i);
+                *audio = update_checksum_u32(*audio, size);
+                *audio = update_checksum(*audio, smacker_get_frame_audio(s, i), size);
+            }
+        }
+        status = smacker_next_frame(s);
+    }
+    smacker_close(s);
+    if (status != SMACKER_FRAME_DONE) {
+        // files that end in a broken frame must keep failing at the same frame
+        *video = update_checksum_u32(*video, status);
+    }
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2 && argc != 6) {
+        printf("Usage: smkcheck FILE [FRAMES VIDEO PALETTE AUDIO]\n");
+        return 1;
+    }
+    int num_frames;
+    uint32_t video, palette, audio;
+    if (!decode(argv[1], &num_frames, &video, &palette, &audio)) {
+        return 1;
+    }
+    printf("%s: %d frames, video %08x, palette %08x, audio %08x\n", argv[1], num_frames, video, palette, audio);
+    if (argc == 2) {
+        return 0;
+    }
+    if (num_frames != atoi(argv[2]) ||
+        video != strtoul(argv[3], 0, 16) || palette != strtoul(argv[4], 0, 16) || audio != strtoul(argv[5], 0, 16)) {
+        printf("Expected %s frames, video %s, palette %s, audio %s\n", argv[2], argv[3], argv[4], argv[5]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,6 @@
+#include "core/file.h"
+
+int file_close(FILE *stream)
+{
+    return fclose(stream);
+}
@@ -9,6 +9,18 @@ void sound_device_close(void)
 void sound_device_init_channels(int num_channels, char filenames[][CHANNEL_FILENAME_MAX])
 {}
 
+void sound_device_preload_channels(int first_channel, int last_channel)
+{}
+
+void sound_device_update(void)
+{}
+
+void sound_device_get_cache_stats(int *hits, int *misses)
+{
+    *hits = 0;
+    *misses = 0;
+}
+
 int sound_device_is_channel_playing(int channel)
 {
     return 0;
@@ -20,7 +32,7 @@ void sound_device_set_music_volume(int volume_pct)
 void sound_device_set_channel_volume(int channel, int volume_pct)
 {}
 
-int sound_device_play_music(const char *filename, int volume_pct)
+int sound_device_play_music(const char *filename, const char *fallback_filename, int volume_pct)
 {
     return 0;
 }
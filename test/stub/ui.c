@@ -1,3 +1,4 @@
+#include "game/system.h"
 #include "graphics/window.h"
 #include "window/message_dialog.h"
 #include "window/popup_dialog.h"
@@ -6,6 +7,29 @@
 
 #include "city/victory.h"
 
+unsigned int system_get_ticks(void)
+{
+    return 0;
+}
+
+int system_background_task_running(background_task_type type)
+{
+    return 0;
+}
+
+int system_start_background_task(background_task_type type, void (*task)(void *data), void *data)
+{
+    return 0;
+}
+
+void system_wait_for_background_task(background_task_type type)
+{}
+
+int system_run_parallel_tasks(void (*task)(int item, int worker, void *data), int num_items, int max_workers, void *data)
+{
+    return 0;
+}
+
 int window_is(window_id id)
 {
     return id == WINDOW_CITY;